@@ -0,0 +1,86 @@
+/*
+ * ACK traces, the input of relentless_bench and relentless_replay, and
+ * the output of relentless_sim -R, pcap2ack and tcp_probe2ack.sh.  A trace
+ * is text, one ACK per line:
+ *
+ *	t_us acked rtt_us ce lost in_flight delivered interval_us [event]
+ *
+ * t_us is the arrival time, acked the packets it newly acked or sacked,
+ * rtt_us the ack_sample RTT (-1 for none), ce 1 if it echoed CE, lost the
+ * packets newly marked lost, in_flight the packets in flight before it,
+ * and delivered / interval_us its delivery rate sample.  event is 0 (or
+ * absent) for an ACK; 1 records an RTO at t_us, with lost the packets it
+ * marked lost and in_flight those outstanding.  Blank lines and lines
+ * starting with '#' are ignored.
+ */
+#ifndef _ACK_TRACE_H
+#define _ACK_TRACE_H
+
+#include <stdio.h>
+
+enum {
+	ACK_TRACE_ACK = 0,
+	ACK_TRACE_RTO = 1,
+};
+
+struct ack_rec {
+	u64 t_us;
+	u32 acked;
+	s32 rtt_us;
+	u32 ce;
+	u32 lost;
+	u32 in_flight;
+	u32 delivered;
+	u32 interval_us;
+	u32 event;
+};
+
+#define ACK_TRACE_HEADER \
+	"# t_us acked rtt_us ce lost in_flight delivered interval_us event\n"
+
+static inline void ack_trace_write(FILE *f, const struct ack_rec *r)
+{
+	fprintf(f, "%llu %u %d %u %u %u %u %u %u\n", (unsigned long long)r->t_us,
+		r->acked, r->rtt_us, r->ce, r->lost, r->in_flight,
+		r->delivered, r->interval_us, r->event);
+}
+
+/* Read a whole trace, returns the number of records or -1 on error */
+static inline long ack_trace_read(FILE *f, struct ack_rec **recs)
+{
+	struct ack_rec *r = NULL, *p;
+	size_t n = 0, cap = 0;
+	unsigned long long t;
+	char line[256];
+	int fields;
+
+	while (fgets(line, sizeof(line), f)) {
+		if (line[0] == '#' || line[0] == '\n')
+			continue;
+		if (n == cap) {
+			cap = cap ? 2 * cap : 4096;
+			p = realloc(r, cap * sizeof(*r));
+			if (!p)
+				goto err;
+			r = p;
+		}
+		p = &r[n];
+		p->event = ACK_TRACE_ACK;
+		fields = sscanf(line, "%llu %u %d %u %u %u %u %u %u", &t, &p->acked,
+				&p->rtt_us, &p->ce, &p->lost, &p->in_flight,
+				&p->delivered, &p->interval_us, &p->event);
+		if (fields != 8 && fields != 9)
+			goto err;
+		p->t_us = t;
+		n++;
+	}
+	if (ferror(f))
+		goto err;
+	*recs = r;
+	return n;
+err:
+	free(r);
+	return -1;
+}
+
+#endif /* _ACK_TRACE_H */
@@ -0,0 +1,67 @@
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench_perf.h"
+
+static const unsigned long long bench_perf_config[BENCH_PERF_NR] = {
+	[BENCH_PERF_CYCLES] = PERF_COUNT_HW_CPU_CYCLES,
+	[BENCH_PERF_INSTRUCTIONS] = PERF_COUNT_HW_INSTRUCTIONS,
+	[BENCH_PERF_CACHE_MISSES] = PERF_COUNT_HW_CACHE_MISSES,
+};
+
+void bench_perf_open(struct bench_perf *p)
+{
+	struct perf_event_attr attr;
+	int i;
+
+	for (i = 0; i < BENCH_PERF_NR; i++) {
+		memset(&attr, 0, sizeof(attr));
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.size = sizeof(attr);
+		attr.config = bench_perf_config[i];
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		p->fd[i] = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+	}
+}
+
+void bench_perf_close(struct bench_perf *p)
+{
+	int i;
+
+	for (i = 0; i < BENCH_PERF_NR; i++) {
+		if (p->fd[i] >= 0)
+			close(p->fd[i]);
+		p->fd[i] = -1;
+	}
+}
+
+void bench_perf_start(struct bench_perf *p)
+{
+	int i;
+
+	for (i = 0; i < BENCH_PERF_NR; i++) {
+		if (p->fd[i] < 0)
+			continue;
+		ioctl(p->fd[i], PERF_EVENT_IOC_RESET, 0);
+		ioctl(p->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+	}
+}
+
+void bench_perf_stop(struct bench_perf *p, long long val[BENCH_PERF_NR])
+{
+	int i;
+
+	for (i = 0; i < BENCH_PERF_NR; i++) {
+		val[i] = -1;
+		if (p->fd[i] < 0)
+			continue;
+		ioctl(p->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+		if (read(p->fd[i], &val[i], sizeof(val[i])) != sizeof(val[i]))
+			val[i] = -1;
+	}
+}
@@ -0,0 +1,27 @@
+/*
+ * Hardware counters for relentless_bench.  This is a separate translation
+ * unit because the uapi perf header cannot be included next to the kernel
+ * shim in sim/include.
+ */
+#ifndef _BENCH_PERF_H
+#define _BENCH_PERF_H
+
+enum {
+	BENCH_PERF_CYCLES,
+	BENCH_PERF_INSTRUCTIONS,
+	BENCH_PERF_CACHE_MISSES,
+	BENCH_PERF_NR,
+};
+
+struct bench_perf {
+	int fd[BENCH_PERF_NR];	/* -1 where the counter is unavailable */
+};
+
+/* Opens what the CPU and perf_event_paranoid allow, user space only */
+void bench_perf_open(struct bench_perf *p);
+void bench_perf_close(struct bench_perf *p);
+void bench_perf_start(struct bench_perf *p);
+/* Stops the counters and stores their values, -1 for unavailable ones */
+void bench_perf_stop(struct bench_perf *p, long long val[BENCH_PERF_NR]);
+
+#endif /* _BENCH_PERF_H */
@@ -0,0 +1,572 @@
+/*
+ * Just enough of the kernel for tcp_relentless.c to build and run in
+ * userspace under the simulator.  The structures only carry the fields the
+ * module touches, so they are not layout compatible with the kernel's; the
+ * functions declared here are in sim_kernel.c.
+ */
+#ifndef _SIM_KERNEL_H
+#define _SIM_KERNEL_H
+
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+typedef u8 __u8;
+typedef u16 __u16;
+typedef u32 __u32;
+typedef u64 __u64;
+typedef u32 __be32;
+
+/* version.h: the shim follows the 6.6 API, see tcp_relentless_compat.h */
+#define KERNEL_VERSION(a, b, c)	(((a) << 16) + ((b) << 8) + ((c) > 255 ? 255 : (c)))
+#define LINUX_VERSION_CODE	KERNEL_VERSION(6, 6, 0)
+
+#define U8_MAX		((u8)~0U)
+#define U16_MAX		((u16)~0U)
+#define U32_MAX		((u32)~0U)
+#define USEC_PER_SEC	1000000UL
+#define HZ		1000
+
+#define __read_mostly
+#define __init
+#define __exit
+#define __net_init
+#define __net_exit
+
+/* Each argument is evaluated once, as in the kernel */
+#define min(a, b)		({ typeof(a) _a = (a); typeof(b) _b = (b); _a < _b ? _a : _b; })
+#define max(a, b)		({ typeof(a) _a = (a); typeof(b) _b = (b); _a > _b ? _a : _b; })
+#define min_t(t, a, b)		({ t _a = (a); t _b = (b); _a < _b ? _a : _b; })
+#define max_t(t, a, b)		({ t _a = (a); t _b = (b); _a > _b ? _a : _b; })
+#define min3(a, b, c)		min(min(a, b), c)
+#define clamp_t(t, v, lo, hi)	min_t(t, max_t(t, v, lo), hi)
+#define DIV_ROUND_UP(n, d)	(((n) + (d) - 1) / (d))
+
+#define READ_ONCE(x)		(x)
+#define WRITE_ONCE(x, v)	((x) = (v))
+#define BUILD_BUG_ON(c)		_Static_assert(!(c), #c)
+#define BUILD_BUG_ON_ZERO(e)	((int)(sizeof(struct { int:(-!!(e)); })))
+#define __same_type(a, b)	__builtin_types_compatible_p(typeof(a), typeof(b))
+#define __must_be_array(a)	BUILD_BUG_ON_ZERO(__same_type((a), &(a)[0]))
+#define ARRAY_SIZE(arr)		(sizeof(arr) / sizeof((arr)[0]) + __must_be_array(arr))
+#define cmpxchg(p, o, n)	(*(p) == (o) ? (*(p) = (n), (o)) : *(p))
+#define __ffs(x)		((unsigned long)__builtin_ctzl(x))
+
+#define GFP_KERNEL	0
+#define GFP_ATOMIC	0
+#define IS_ENABLED(option)	0
+
+static inline void *kmemdup(const void *p, size_t n, int gfp)
+{
+	void *q = malloc(n);
+
+	if (q)
+		memcpy(q, p, n);
+	return q;
+}
+
+static inline void kfree(const void *p)
+{
+	free((void *)p);
+}
+
+static inline void *kzalloc(size_t n, int gfp)
+{
+	return calloc(1, n);
+}
+
+/* Single threaded: atomics, locks and RCU reduce to plain accesses */
+typedef struct {
+	int counter;
+} atomic_t;
+
+#define atomic_read(v)		((v)->counter)
+#define atomic_inc_return(v)	(++(v)->counter)
+#define atomic_dec(v)		((v)->counter--)
+#define atomic_add(i, v)	((v)->counter += (i))
+#define atomic_sub(i, v)	((v)->counter -= (i))
+
+typedef int spinlock_t;
+#define DEFINE_SPINLOCK(x)	spinlock_t x
+#define spin_lock_bh(l)		((void)(l))
+#define spin_unlock_bh(l)	((void)(l))
+
+struct rcu_head {
+	void *next;
+};
+
+#define rcu_read_lock()		do { } while (0)
+#define rcu_read_unlock()	do { } while (0)
+#define kfree_rcu(p, field)	kfree(p)
+
+/* hashtable.h, on the kernel's hlist layout */
+struct hlist_node {
+	struct hlist_node *next, **pprev;
+};
+
+struct hlist_head {
+	struct hlist_node *first;
+};
+
+#define container_of(ptr, type, member) \
+	((type *)((char *)(ptr) - offsetof(type, member)))
+#define hlist_entry_safe(ptr, type, member) \
+	((ptr) ? container_of(ptr, type, member) : NULL)
+
+static inline void hlist_add_head(struct hlist_node *n, struct hlist_head *h)
+{
+	n->next = h->first;
+	if (h->first)
+		h->first->pprev = &n->next;
+	h->first = n;
+	n->pprev = &h->first;
+}
+
+static inline void hlist_del(struct hlist_node *n)
+{
+	*n->pprev = n->next;
+	if (n->next)
+		n->next->pprev = n->pprev;
+}
+
+#define DEFINE_HASHTABLE(name, bits)	struct hlist_head name[1 << (bits)]
+#define HASH_SIZE(name)			(sizeof(name) / sizeof((name)[0]))
+#define hash_min(key, name)		((u32)(key) * 0x61C88647u >> (32 - __builtin_ctz(HASH_SIZE(name))))
+#define hash_add_rcu(name, node, key)	hlist_add_head(node, &(name)[hash_min(key, name)])
+#define hash_del_rcu(node)		hlist_del(node)
+
+#define hash_for_each_possible(name, obj, member, key) \
+	for (obj = hlist_entry_safe((name)[hash_min(key, name)].first, typeof(*(obj)), member); \
+	     obj; obj = hlist_entry_safe((obj)->member.next, typeof(*(obj)), member))
+#define hash_for_each_possible_rcu	hash_for_each_possible
+
+#define hash_for_each_safe(name, bkt, tmp, obj, member) \
+	for ((bkt) = 0; (bkt) < (int)HASH_SIZE(name); (bkt)++) \
+		for (obj = hlist_entry_safe((name)[bkt].first, typeof(*(obj)), member); \
+		     obj && ((tmp) = (obj)->member.next, 1); \
+		     obj = hlist_entry_safe(tmp, typeof(*(obj)), member))
+
+u32 jhash2(const u32 *k, u32 length, u32 initval);
+
+static inline u64 div_u64(u64 a, u32 b)
+{
+	return a / b;
+}
+
+static inline u64 div64_u64(u64 a, u64 b)
+{
+	return a / b;
+}
+
+static inline bool before(u32 seq1, u32 seq2)
+{
+	return (s32)(seq1 - seq2) < 0;
+}
+#define after(seq2, seq1)	before(seq1, seq2)
+
+/* module.h */
+struct module {
+	int unused;
+};
+extern struct module __this_module;
+#define THIS_MODULE	(&__this_module)
+
+/* moduleparam.h, type checked as in the kernel but never registered */
+struct kernel_param {
+	void *arg;
+};
+
+struct kernel_param_ops {
+	int (*set)(const char *val, const struct kernel_param *kp);
+	int (*get)(char *buffer, const struct kernel_param *kp);
+};
+
+extern const struct kernel_param_ops param_ops_uint;
+extern const struct kernel_param_ops param_ops_bool;
+int param_get_uint(char *buffer, const struct kernel_param *kp);
+int kstrtouint(const char *s, unsigned int base, unsigned int *res);
+
+#define __param_check(name, p, type) \
+	static inline type __attribute__((unused)) *__check_##name(void) { return (p); }
+#define param_check_uint(name, p)	__param_check(name, p, unsigned int)
+#define param_check_bool(name, p)	__param_check(name, p, bool)
+
+#define module_param_named(name, value, type, perm)			\
+	param_check_##type(name, &(value));				\
+	static const struct kernel_param_ops __attribute__((unused))	\
+		*const __param_ops_##name = &param_ops_##type
+#define module_param(name, type, perm)					\
+	param_check_##type(name, &(name));				\
+	static const struct kernel_param_ops __attribute__((unused))	\
+		*const __param_ops_##name = &param_ops_##type
+#define module_param_array(name, type, nump, perm)			\
+	param_check_##type(name, &(name)[0]);				\
+	static const struct kernel_param_ops __attribute__((unused))	\
+		*const __param_ops_##name = &param_ops_##type
+#define MODULE_PARM_DESC(name, desc)
+#define MODULE_AUTHOR(x)
+#define MODULE_LICENSE(x)
+#define MODULE_DESCRIPTION(x)
+#define MODULE_ALIAS(x)
+#define module_init(fn)
+#define module_exit(fn)
+
+/* win_minmax.h */
+struct minmax_sample {
+	u32 t;
+	u32 v;
+};
+
+struct minmax {
+	struct minmax_sample s[3];
+};
+
+static inline u32 minmax_get(const struct minmax *m)
+{
+	return m->s[0].v;
+}
+
+static inline u32 minmax_reset(struct minmax *m, u32 t, u32 meas)
+{
+	struct minmax_sample val = { .t = t, .v = meas };
+
+	m->s[2] = m->s[1] = m->s[0] = val;
+	return m->s[0].v;
+}
+
+u32 minmax_running_min(struct minmax *m, u32 win, u32 t, u32 meas);
+
+/* Namespaces and sysctls, there is only init_net */
+struct netns_ipv4 {
+	u8 sysctl_tcp_min_tso_segs;
+};
+
+struct net {
+	void *gen;
+	struct proc_dir_entry *proc_net;
+	struct netns_ipv4 ipv4;
+};
+
+extern struct net init_net;
+
+static inline bool net_eq(const struct net *a, const struct net *b)
+{
+	return a == b;
+}
+
+typedef struct {
+	struct net *net;
+} possible_net_t;
+
+static inline void write_pnet(possible_net_t *pnet, struct net *net)
+{
+	pnet->net = net;
+}
+
+static inline struct net *read_pnet(const possible_net_t *pnet)
+{
+	return pnet->net;
+}
+
+static inline u32 net_hash_mix(const struct net *net)
+{
+	return 0;
+}
+
+static inline void *net_generic(const struct net *net, unsigned int id)
+{
+	return net->gen;
+}
+
+struct pernet_operations {
+	int (*init)(struct net *net);
+	void (*exit)(struct net *net);
+	unsigned int *id;
+	size_t size;
+};
+
+int register_pernet_subsys(struct pernet_operations *ops);
+void unregister_pernet_subsys(struct pernet_operations *ops);
+
+struct ctl_table {
+	const char *procname;
+	void *data;
+	int maxlen;
+	int mode;
+	int (*proc_handler)(void);
+	void *extra1;
+	void *extra2;
+};
+
+struct ctl_table_header {
+	struct ctl_table *ctl_table_arg;
+};
+
+int proc_douintvec(void);
+int proc_douintvec_minmax(void);
+struct ctl_table_header *register_net_sysctl_sz(struct net *net, const char *path,
+						struct ctl_table *table, size_t table_size);
+/* As since 6.6, only for arrays */
+#define register_net_sysctl(net, path, table) \
+	register_net_sysctl_sz(net, path, table, ARRAY_SIZE(table))
+void unregister_net_sysctl_table(struct ctl_table_header *header);
+
+/* percpu.h, a single CPU */
+#define __percpu
+#define alloc_percpu(type)		((type *)calloc(1, sizeof(type)))
+#define free_percpu(p)			free(p)
+#define per_cpu_ptr(p, cpu)		(p)
+#define this_cpu_inc(var)		((var)++)
+#define for_each_possible_cpu(cpu)	for ((cpu) = 0; (cpu) < 1; (cpu)++)
+
+static inline int fls(u32 x)
+{
+	return x ? 32 - __builtin_clz(x) : 0;
+}
+
+/* seq_file.h and proc_fs.h: one entry, shown by sim_proc_show() */
+struct seq_file {
+	FILE *f;
+	struct net *net;
+};
+
+#define seq_printf(seq, ...)	fprintf((seq)->f, __VA_ARGS__)
+#define seq_puts(seq, s)	fputs(s, (seq)->f)
+#define seq_putc(seq, c)	fputc(c, (seq)->f)
+
+static inline struct net *seq_file_single_net(struct seq_file *seq)
+{
+	return seq->net;
+}
+
+struct proc_dir_entry;
+
+struct proc_dir_entry *proc_create_net_single(const char *name, int mode,
+					      struct proc_dir_entry *parent,
+					      int (*show)(struct seq_file *, void *),
+					      void *data);
+void remove_proc_entry(const char *name, struct proc_dir_entry *parent);
+void sim_proc_show(FILE *f);
+
+/* tcp.h */
+enum {
+	SK_PACING_NONE,
+	SK_PACING_NEEDED,
+	SK_PACING_FQ,
+};
+
+#define ICSK_ACK_TIMER		2
+#define ICSK_ACK_NOW		8
+#define TCP_ECN_OK		1
+#define TCP_ECN_DEMAND_CWR	4
+#define TCP_CONG_NEEDS_ECN	0x2
+#define CA_ACK_ECE		4
+#define TCP_INFINITE_SSTHRESH	0x7fffffff
+#define INET_DIAG_VEGASINFO	3
+
+enum tcp_ca_event {
+	CA_EVENT_TX_START,
+	CA_EVENT_CWND_RESTART,
+	CA_EVENT_COMPLETE_CWR,
+	CA_EVENT_LOSS,
+	CA_EVENT_ECN_NO_CE,
+	CA_EVENT_ECN_IS_CE,
+};
+
+enum {
+	TCP_CA_Open,
+	TCP_CA_Disorder,
+	TCP_CA_CWR,
+	TCP_CA_Recovery,
+	TCP_CA_Loss,
+};
+
+#define TCPF_CA_CWR		(1 << TCP_CA_CWR)
+#define TCPF_CA_Recovery	(1 << TCP_CA_Recovery)
+
+struct ack_sample {
+	u32 pkts_acked;
+	s32 rtt_us;
+	u32 in_flight;
+};
+
+struct rate_sample {
+	u64 prior_mstamp;
+	u32 prior_delivered;
+	u32 prior_delivered_ce;
+	s32 delivered;
+	s32 delivered_ce;
+	long interval_us;
+	u32 snd_interval_us;
+	u32 rcv_interval_us;
+	long rtt_us;
+	int losses;
+	u32 acked_sacked;
+	u32 prior_in_flight;
+	u32 last_end_seq;
+	bool is_app_limited;
+	bool is_retrans;
+	bool is_ack_delayed;
+};
+
+union tcp_cc_info {
+	struct { u32 a[4]; } vegas;
+	struct { u32 a[4]; } dctcp;
+	struct { u32 a[5]; } bbr;
+};
+
+struct sock;
+
+struct tcp_congestion_ops {
+	u32 (*ssthresh)(struct sock *sk);
+	void (*cong_avoid)(struct sock *sk, u32 ack, u32 acked);
+	void (*set_state)(struct sock *sk, u8 new_state);
+	void (*cwnd_event)(struct sock *sk, enum tcp_ca_event ev);
+	void (*in_ack_event)(struct sock *sk, u32 flags);
+	void (*pkts_acked)(struct sock *sk, const struct ack_sample *sample);
+	u32 (*min_tso_segs)(struct sock *sk);
+	void (*cong_control)(struct sock *sk, const struct rate_sample *rs);
+	u32 (*undo_cwnd)(struct sock *sk);
+	u32 (*sndbuf_expand)(struct sock *sk);
+	size_t (*get_info)(struct sock *sk, u32 ext, int *attr,
+			   union tcp_cc_info *info);
+	char name[16];
+	struct module *owner;
+	void (*init)(struct sock *sk);
+	void (*release)(struct sock *sk);
+	u32 flags;
+};
+
+#define ICSK_CA_PRIV_SIZE	(13 * sizeof(u64))
+
+#define AF_INET		2
+#define AF_INET6	10
+
+struct sock {
+	struct net *net;
+	u16 sk_family;
+	u32 sk_mark;
+	int sk_pacing_status;
+	unsigned long sk_pacing_rate;
+	unsigned long sk_max_pacing_rate;
+	u32 sk_pacing_shift;
+	int sk_gso_max_size;
+};
+
+struct inet_sock {
+	struct sock sk;
+	__be32 inet_saddr, inet_daddr;
+	u16 inet_sport, inet_dport;
+};
+
+struct inet_connection_sock {
+	struct inet_sock icsk_inet;
+	const struct tcp_congestion_ops *icsk_ca_ops;
+	u8 icsk_ca_state;
+	struct {
+		u8 pending;
+	} icsk_ack;
+	u32 icsk_rto;
+	u64 icsk_ca_priv[ICSK_CA_PRIV_SIZE / sizeof(u64)];
+};
+
+struct tcp_sock {
+	struct inet_connection_sock icsk;
+	u32 snd_cwnd, snd_ssthresh, snd_cwnd_clamp, snd_cwnd_cnt, snd_cwnd_stamp;
+	u32 prior_cwnd, prior_ssthresh;
+	u32 snd_una, snd_nxt, rcv_nxt;
+	u32 packets_out, sacked_out, lost_out, retrans_out, total_retrans;
+	u32 delivered, delivered_ce, lost;
+	u32 srtt_us;	/* << 3, as in the kernel */
+	u32 mss_cache, lsndtime, undo_marker;
+	u64 tcp_mstamp;
+	u8 ecn_flags;
+	bool is_cwnd_limited;
+	u32 app_limited;
+	u32 max_packets_out;
+};
+
+static inline struct inet_sock *inet_sk(const struct sock *sk)
+{
+	return (struct inet_sock *)sk;
+}
+
+static inline struct tcp_sock *tcp_sk(const struct sock *sk)
+{
+	return (struct tcp_sock *)sk;
+}
+
+static inline struct inet_connection_sock *inet_csk(const struct sock *sk)
+{
+	return (struct inet_connection_sock *)sk;
+}
+
+static inline void *inet_csk_ca(const struct sock *sk)
+{
+	return (void *)inet_csk(sk)->icsk_ca_priv;
+}
+
+static inline struct net *sock_net(const struct sock *sk)
+{
+	return sk->net;
+}
+
+extern u32 tcp_jiffies32;
+
+static inline u32 tcp_snd_cwnd(const struct tcp_sock *tp)
+{
+	return tp->snd_cwnd;
+}
+
+static inline void tcp_snd_cwnd_set(struct tcp_sock *tp, u32 val)
+{
+	tp->snd_cwnd = val;
+}
+
+static inline u32 tcp_packets_in_flight(const struct tcp_sock *tp)
+{
+	return tp->packets_out - (tp->sacked_out + tp->lost_out) + tp->retrans_out;
+}
+
+static inline bool tcp_in_slow_start(const struct tcp_sock *tp)
+{
+	return tp->snd_cwnd < tp->snd_ssthresh;
+}
+
+static inline bool tcp_is_cwnd_limited(const struct sock *sk)
+{
+	const struct tcp_sock *tp = tcp_sk(sk);
+
+	if (tcp_in_slow_start(tp))
+		return tp->snd_cwnd < 2 * tp->max_packets_out;
+	return tp->is_cwnd_limited;
+}
+
+static inline bool tcp_in_cwnd_reduction(const struct sock *sk)
+{
+	return (TCPF_CA_CWR | TCPF_CA_Recovery) & (1 << inet_csk(sk)->icsk_ca_state);
+}
+
+u32 tcp_slow_start(struct tcp_sock *tp, u32 acked);
+void tcp_cong_avoid_ai(struct tcp_sock *tp, u32 w, u32 acked);
+void __tcp_send_ack(struct sock *sk, u32 rcv_nxt);
+int tcp_register_congestion_control(struct tcp_congestion_ops *ca);
+void tcp_unregister_congestion_control(struct tcp_congestion_ops *ca);
+
+/* The simulator looks the registered ops up by name */
+struct tcp_congestion_ops *sim_find_congestion_control(const char *name);
+
+#endif /* _SIM_KERNEL_H */
@@ -0,0 +1 @@
+/* nothing to define, see linux/tracepoint.h */
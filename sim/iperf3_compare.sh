@@ -0,0 +1,61 @@
+#!/bin/sh
+# End to end comparison of congestion controls on a real path.
+#
+#	sim/iperf3_compare.sh [-t secs] [-P streams] [-c "cc ..."] server
+#
+# Runs iperf3 against server (which runs "iperf3 -s") once per congestion
+# control, relentless, cubic and bbr by default, while sampling the
+# connections' RTT with ss every 100ms.  Prints one key=value line per
+# congestion control: throughput, sender and receiver CPU%, retransmits
+# and the RTT distribution.  Needs iperf3, jq and ss, and the module
+# loaded (and in net.ipv4.tcp_allowed_congestion_control unless root).
+DURATION=20
+STREAMS=1
+CCS="relentless cubic bbr"
+
+while getopts t:P:c: opt; do
+	case $opt in
+	t) DURATION=$OPTARG ;;
+	P) STREAMS=$OPTARG ;;
+	c) CCS=$OPTARG ;;
+	*) echo "usage: $0 [-t secs] [-P streams] [-c \"cc ...\"] server" >&2; exit 1 ;;
+	esac
+done
+shift $((OPTIND - 1))
+SERVER=$1
+[ -n "$SERVER" ] || { echo "usage: $0 [-t secs] [-P streams] [-c \"cc ...\"] server" >&2; exit 1; }
+
+for tool in iperf3 jq ss; do
+	command -v $tool >/dev/null || { echo "$0: $tool not found" >&2; exit 1; }
+done
+
+TMP=$(mktemp -d) || exit 1
+trap 'rm -rf "$TMP"' EXIT
+
+for cc in $CCS; do
+	iperf3 -c "$SERVER" -C "$cc" -t "$DURATION" -P "$STREAMS" -J > "$TMP/iperf3.json" &
+	pid=$!
+
+	# rtt:<srtt>/<rttvar> in ms, one line per connection and sample
+	: > "$TMP/rtt"
+	while kill -0 $pid 2>/dev/null; do
+		ss -tin dst "$SERVER" 2>/dev/null | grep -o 'rtt:[0-9.]*' | cut -d: -f2 >> "$TMP/rtt"
+		sleep 0.1
+	done
+	wait $pid || { echo "$0: iperf3 with $cc failed" >&2; continue; }
+
+	jq -r --arg cc "$cc" '"cc=\($cc) mbps=\(.end.sum_received.bits_per_second / 1e6 | floor)" +
+		" cpu_local=\(.end.cpu_utilization_percent.host_total * 10 | floor / 10)" +
+		" cpu_remote=\(.end.cpu_utilization_percent.remote_total * 10 | floor / 10)" +
+		" retrans=\(.end.sum_sent.retransmits)"' "$TMP/iperf3.json" | tr -d '\n'
+
+	sort -n "$TMP/rtt" | awk '
+		function q(p,	i) { i = int(NR * p) + 1; return v[i > NR ? NR : i] }
+		{ v[NR] = $1; sum += $1 }
+		END {
+			if (!NR) { print " rtt_samples=0"; exit }
+			printf " rtt_samples=%d rtt_mean_ms=%.3f rtt_p50_ms=%.3f rtt_p90_ms=%.3f",
+				NR, sum / NR, q(0.5), q(0.9)
+			printf " rtt_p99_ms=%.3f rtt_max_ms=%.3f\n", q(0.99), v[NR]
+		}'
+done
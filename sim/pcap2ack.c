@@ -0,0 +1,477 @@
+/*
+ * Convert a sender side packet capture of one TCP connection into an
+ * ack_trace.h ACK trace for relentless_replay.
+ *
+ *	pcap2ack [-p port] [-m mss] [-r rto_min_ms] capture.pcap > trace
+ *
+ * Reads classic pcap files (Ethernet, raw IP or Linux cooked captures,
+ * IPv4 or IPv6, no libpcap needed).  The connection is the first one seen
+ * carrying data, or the first on the given port.  Data segments are
+ * tracked in packets of mss bytes, the first segment's payload unless -m
+ * is given (which GSO captures need), and each ACK from the receiver becomes
+ * one record: the packets it newly cumulatively acked or sacked, the RTT
+ * of the newest of them that was never retransmitted (as the stack's
+ * ca_rtt_us), ECE, and the delivery rate sample as tcp_rate.c computes it.
+ * A retransmission marks the retransmitted packets lost on the next ACK;
+ * one of snd_una after at least rto_min (200ms) without an ACK is recorded
+ * as an RTO instead.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define PCAP_MAGIC		0xa1b2c3d4
+#define PCAP_MAGIC_NSEC		0xa1b23c4d
+#define LINKTYPE_ETHERNET	1
+#define LINKTYPE_RAW		101
+#define LINKTYPE_LINUX_SLL	113
+
+#define TH_SYN	0x02
+#define TH_RST	0x04
+#define TH_ACK	0x10
+#define TH_ECE	0x40
+
+#define TCPOPT_EOL	0
+#define TCPOPT_NOP	1
+#define TCPOPT_SACK	5
+
+#define SEG_SACKED	0x1
+#define SEG_RETRANS	0x2
+
+struct endpoint {
+	uint8_t addr[16];
+	uint16_t port;
+	int family;
+};
+
+/* One packet of mss bytes, in sequence order from snd_una */
+struct seg {
+	uint64_t tx_us;
+	uint64_t prior_delivered_us;
+	uint32_t prior_delivered;
+	uint8_t flags;
+};
+
+static struct {
+	int filter_port;
+	uint32_t mss;
+	uint64_t rto_min_us;
+
+	bool swapped, nsec;
+	uint32_t linktype;
+
+	bool have_flow;
+	struct endpoint snd, rcv;
+	uint32_t isn;		/* data sequence numbers are relative to this */
+	uint64_t high_seq;	/* relative, highest byte sent + 1 */
+
+	struct seg *segs;	/* una_pkt..nxt_pkt - 1, indexed modulo cap */
+	uint64_t una_pkt, nxt_pkt, cap;
+	uint32_t delivered;
+	uint64_t delivered_us;
+	uint64_t last_ack_us, last_rto_us;
+	uint64_t loss_high;	/* nxt_pkt at the last RTO */
+	uint32_t pending_lost;
+	uint64_t t0;		/* times are relative to the first packet */
+	uint64_t pkts_in;
+} p2a = {
+	.rto_min_us = 200000,
+};
+
+static uint16_t get16(const uint8_t *p)
+{
+	return p[0] << 8 | p[1];
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+	return (uint32_t)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+}
+
+static uint32_t pcap32(uint32_t v)
+{
+	return p2a.swapped ? __builtin_bswap32(v) : v;
+}
+
+static struct seg *seg_at(uint64_t pkt)
+{
+	return &p2a.segs[pkt % p2a.cap];
+}
+
+static void segs_grow(void)
+{
+	uint64_t cap = p2a.cap ? 2 * p2a.cap : 4096, pkt;
+	struct seg *segs = calloc(cap, sizeof(*segs));
+
+	if (!segs) {
+		fprintf(stderr, "pcap2ack: out of memory\n");
+		exit(1);
+	}
+	for (pkt = p2a.una_pkt; pkt < p2a.nxt_pkt; pkt++)
+		segs[pkt % cap] = *seg_at(pkt);
+	free(p2a.segs);
+	p2a.segs = segs;
+	p2a.cap = cap;
+}
+
+static uint32_t in_flight(void)
+{
+	uint64_t pkt;
+	uint32_t n = 0;
+
+	for (pkt = p2a.una_pkt; pkt < p2a.nxt_pkt; pkt++)
+		if (!(seg_at(pkt)->flags & SEG_SACKED))
+			n++;
+	return n;
+}
+
+/* Relative sequence of seq, nearest to hint, across wraps */
+static uint64_t unwrap(uint32_t seq, uint64_t hint)
+{
+	return hint + (int32_t)(seq - p2a.isn - (uint32_t)hint);
+}
+
+static void on_data(uint64_t now, uint32_t seq, uint32_t len)
+{
+	uint64_t start = unwrap(seq, p2a.high_seq), end = start + len, pkt;
+	uint64_t first = start / p2a.mss, last = (end + p2a.mss - 1) / p2a.mss;
+
+	if (end > p2a.high_seq)
+		p2a.high_seq = end;
+
+	/* retransmission of what was already sent */
+	for (pkt = first < p2a.una_pkt ? p2a.una_pkt : first;
+	     pkt < last && pkt < p2a.nxt_pkt; pkt++) {
+		struct seg *s = seg_at(pkt);
+
+		if (s->flags & SEG_SACKED)
+			continue;
+		if (pkt == p2a.una_pkt &&
+		    now - (p2a.last_ack_us > p2a.last_rto_us ? p2a.last_ack_us : p2a.last_rto_us) >=
+		    p2a.rto_min_us) {
+			uint32_t outstanding = in_flight();
+
+			/* everything outstanding is marked lost, as tcp_enter_loss */
+			printf("%llu 0 -1 0 %u %u 0 0 1\n", (unsigned long long)now,
+			       outstanding, outstanding);
+			p2a.last_rto_us = now;
+			p2a.loss_high = p2a.nxt_pkt;
+			p2a.pending_lost = 0;
+		}
+		if (!(s->flags & SEG_RETRANS) && p2a.una_pkt >= p2a.loss_high)
+			p2a.pending_lost++;
+		s->flags |= SEG_RETRANS;
+		s->tx_us = now;
+		s->prior_delivered = p2a.delivered;
+		s->prior_delivered_us = p2a.delivered_us;
+	}
+
+	for (pkt = p2a.nxt_pkt; pkt < last; pkt++) {
+		struct seg *s;
+
+		if (pkt - p2a.una_pkt >= p2a.cap)
+			segs_grow();
+		s = seg_at(pkt);
+		memset(s, 0, sizeof(*s));
+		s->tx_us = now;
+		s->prior_delivered = p2a.delivered;
+		s->prior_delivered_us = p2a.delivered_us ? p2a.delivered_us : now;
+		p2a.nxt_pkt = pkt + 1;
+	}
+}
+
+static void on_ack(uint64_t now, uint32_t ack, bool ece, const uint8_t *opt, int optlen)
+{
+	uint64_t ack_pkt = unwrap(ack, p2a.high_seq) / p2a.mss, pkt;
+	uint32_t prior_in_flight = in_flight(), acked = 0;
+	struct seg *newest = NULL;
+	int64_t rtt_us = -1;
+
+	if (ack_pkt > p2a.nxt_pkt)
+		ack_pkt = p2a.nxt_pkt;
+
+	/* SACK blocks */
+	while (optlen > 0) {
+		int kind = opt[0], len;
+
+		if (kind == TCPOPT_EOL)
+			break;
+		if (kind == TCPOPT_NOP) {
+			opt++;
+			optlen--;
+			continue;
+		}
+		if (optlen < 2 || (len = opt[1]) < 2 || len > optlen)
+			break;
+		if (kind == TCPOPT_SACK) {
+			int i;
+
+			for (i = 2; i + 8 <= len; i += 8) {
+				uint64_t l = unwrap(get32(opt + i), p2a.high_seq);
+				uint64_t r = unwrap(get32(opt + i + 4), p2a.high_seq);
+
+				for (pkt = (l + p2a.mss - 1) / p2a.mss;
+				     pkt < r / p2a.mss && pkt < p2a.nxt_pkt; pkt++) {
+					struct seg *s;
+
+					if (pkt < p2a.una_pkt)
+						continue;
+					s = seg_at(pkt);
+					if (s->flags & SEG_SACKED)
+						continue;
+					s->flags |= SEG_SACKED;
+					acked++;
+					if (!newest || s->tx_us > newest->tx_us)
+						newest = s;
+				}
+			}
+		}
+		opt += len;
+		optlen -= len;
+	}
+
+	for (pkt = p2a.una_pkt; pkt < ack_pkt; pkt++) {
+		struct seg *s = seg_at(pkt);
+
+		if (!(s->flags & SEG_SACKED)) {
+			acked++;
+			if (!newest || s->tx_us > newest->tx_us)
+				newest = s;
+		}
+	}
+
+	if (!acked && !p2a.pending_lost)
+		return;
+
+	p2a.delivered += acked;
+	p2a.delivered_us = now;
+	p2a.last_ack_us = now;
+
+	if (newest && !(newest->flags & SEG_RETRANS))
+		rtt_us = now - newest->tx_us;
+
+	printf("%llu %u %lld %d %u %u %u %llu 0\n", (unsigned long long)now, acked,
+	       (long long)rtt_us, ece, p2a.pending_lost, prior_in_flight,
+	       newest ? p2a.delivered - newest->prior_delivered : 0,
+	       newest ? (unsigned long long)(now - newest->prior_delivered_us) : 0ULL);
+	p2a.pending_lost = 0;
+
+	/* drop cumulatively acked packets from the front */
+	if (ack_pkt > p2a.una_pkt)
+		p2a.una_pkt = ack_pkt;
+}
+
+static bool endpoint_eq(const struct endpoint *a, const struct endpoint *b)
+{
+	return a->family == b->family && a->port == b->port &&
+	       !memcmp(a->addr, b->addr, a->family == 4 ? 4 : 16);
+}
+
+static void on_tcp(uint64_t now, const struct endpoint *src, const struct endpoint *dst,
+		   const uint8_t *th, uint32_t len)
+{
+	uint32_t doff, payload, seq;
+	uint8_t flags;
+
+	if (len < 20)
+		return;
+	doff = (th[12] >> 4) * 4;
+	if (doff < 20 || doff > len)
+		return;
+	flags = th[13];
+	seq = get32(th + 4);
+	payload = len - doff;
+
+	if (!p2a.have_flow) {
+		if (!payload || (flags & (TH_SYN | TH_RST)))
+			return;
+		if (p2a.filter_port >= 0 && src->port != p2a.filter_port &&
+		    dst->port != p2a.filter_port)
+			return;
+		p2a.have_flow = true;
+		p2a.snd = *src;
+		p2a.rcv = *dst;
+		p2a.isn = seq;
+		if (!p2a.mss)
+			p2a.mss = payload;
+		fprintf(stderr, "pcap2ack: sender port %u, receiver port %u, mss %u\n",
+			src->port, dst->port, p2a.mss);
+	}
+
+	if (endpoint_eq(src, &p2a.snd) && endpoint_eq(dst, &p2a.rcv)) {
+		if (payload)
+			on_data(now, seq, payload);
+	} else if (endpoint_eq(src, &p2a.rcv) && endpoint_eq(dst, &p2a.snd)) {
+		if (flags & TH_ACK)
+			on_ack(now, get32(th + 8), flags & TH_ECE, th + 20, doff - 20);
+	}
+}
+
+static void on_ip(uint64_t now, const uint8_t *p, uint32_t len)
+{
+	struct endpoint src = { 0 }, dst = { 0 };
+	uint32_t hl, tot;
+
+	if (len < 1)
+		return;
+	if ((p[0] >> 4) == 4) {
+		if (len < 20 || p[9] != 6)
+			return;
+		hl = (p[0] & 0xf) * 4;
+		tot = get16(p + 2);
+		if (hl < 20 || tot > len || tot < hl)
+			return;
+		src.family = dst.family = 4;
+		memcpy(src.addr, p + 12, 4);
+		memcpy(dst.addr, p + 16, 4);
+	} else if ((p[0] >> 4) == 6) {
+		/* extension headers are not followed */
+		if (len < 40 || p[6] != 6)
+			return;
+		hl = 40;
+		tot = 40 + get16(p + 4);
+		if (tot > len)
+			return;
+		src.family = dst.family = 6;
+		memcpy(src.addr, p + 8, 16);
+		memcpy(dst.addr, p + 24, 16);
+	} else {
+		return;
+	}
+	if (tot - hl < 4)
+		return;
+	src.port = get16(p + hl);
+	dst.port = get16(p + hl + 2);
+	on_tcp(now, &src, &dst, p + hl, tot - hl);
+}
+
+static void on_frame(uint64_t now, const uint8_t *p, uint32_t len)
+{
+	uint32_t off;
+	uint16_t type;
+
+	switch (p2a.linktype) {
+	case LINKTYPE_RAW:
+		on_ip(now, p, len);
+		return;
+	case LINKTYPE_ETHERNET:
+		off = 14;
+		if (len < off)
+			return;
+		type = get16(p + 12);
+		while ((type == 0x8100 || type == 0x88a8) && len >= off + 4) {
+			type = get16(p + off + 2);
+			off += 4;
+		}
+		break;
+	case LINKTYPE_LINUX_SLL:
+		off = 16;
+		if (len < off)
+			return;
+		type = get16(p + 14);
+		break;
+	default:
+		return;
+	}
+	if (type == 0x0800 || type == 0x86dd)
+		on_ip(now, p + off, len - off);
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: pcap2ack [-p port] [-m mss] [-r rto_min_ms] capture.pcap\n");
+}
+
+int main(int argc, char **argv)
+{
+	uint8_t hdr[24], rec[16], *buf = NULL;
+	uint32_t snaplen, caplen, magic;
+	FILE *f;
+	int c;
+
+	p2a.filter_port = -1;
+	while ((c = getopt(argc, argv, "p:m:r:h")) != -1) {
+		switch (c) {
+		case 'p': p2a.filter_port = strtoul(optarg, NULL, 0); break;
+		case 'm': p2a.mss = strtoul(optarg, NULL, 0); break;
+		case 'r': p2a.rto_min_us = strtod(optarg, NULL) * 1000; break;
+		default:
+			usage();
+			return c == 'h' ? 0 : 1;
+		}
+	}
+	if (optind != argc - 1) {
+		usage();
+		return 1;
+	}
+
+	f = fopen(argv[optind], "rb");
+	if (!f) {
+		perror(argv[optind]);
+		return 1;
+	}
+	if (fread(hdr, sizeof(hdr), 1, f) != 1)
+		goto bad;
+	memcpy(&magic, hdr, 4);
+	if (magic == PCAP_MAGIC || magic == PCAP_MAGIC_NSEC) {
+		p2a.swapped = false;
+	} else if (__builtin_bswap32(magic) == PCAP_MAGIC ||
+		   __builtin_bswap32(magic) == PCAP_MAGIC_NSEC) {
+		p2a.swapped = true;
+		magic = __builtin_bswap32(magic);
+	} else {
+		fprintf(stderr, "pcap2ack: %s: not a pcap file (pcapng is not supported)\n",
+			argv[optind]);
+		return 1;
+	}
+	p2a.nsec = magic == PCAP_MAGIC_NSEC;
+	memcpy(&snaplen, hdr + 16, 4);
+	snaplen = pcap32(snaplen);
+	memcpy(&p2a.linktype, hdr + 20, 4);
+	p2a.linktype = pcap32(p2a.linktype) & 0xffff;
+	if (p2a.linktype != LINKTYPE_ETHERNET && p2a.linktype != LINKTYPE_RAW &&
+	    p2a.linktype != LINKTYPE_LINUX_SLL) {
+		fprintf(stderr, "pcap2ack: unsupported link type %u\n", p2a.linktype);
+		return 1;
+	}
+	if (!snaplen || snaplen > 262144)
+		snaplen = 262144;
+	buf = malloc(snaplen);
+	if (!buf)
+		goto bad;
+
+	printf("# t_us acked rtt_us ce lost in_flight delivered interval_us event\n");
+	while (fread(rec, sizeof(rec), 1, f) == 1) {
+		uint32_t sec, frac;
+		uint64_t now;
+
+		memcpy(&sec, rec, 4);
+		memcpy(&frac, rec + 4, 4);
+		memcpy(&caplen, rec + 8, 4);
+		sec = pcap32(sec);
+		frac = pcap32(frac);
+		caplen = pcap32(caplen);
+		if (caplen > snaplen || fread(buf, caplen, 1, f) != 1)
+			goto bad;
+		now = sec * 1000000ULL + (p2a.nsec ? frac / 1000 : frac);
+		if (!p2a.pkts_in)
+			p2a.t0 = now;
+		on_frame(now - p2a.t0, buf, caplen);
+		p2a.pkts_in++;
+	}
+	if (!p2a.have_flow) {
+		fprintf(stderr, "pcap2ack: no TCP data found in %llu packets\n",
+			(unsigned long long)p2a.pkts_in);
+		return 1;
+	}
+	free(buf);
+	fclose(f);
+	return 0;
+bad:
+	fprintf(stderr, "pcap2ack: %s: truncated or unreadable\n", argv[optind]);
+	return 1;
+}
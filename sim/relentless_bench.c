@@ -0,0 +1,395 @@
+/*
+ * Relentless TCP per-ACK cost.
+ *
+ * Replays an ACK stream (an ack_trace.h trace, e.g. from relentless_sim
+ * -R, or a synthetic one) through the congestion ops in the order the
+ * kernel calls them on an ACK in the Open state: in_ack_event, pkts_acked,
+ * then cong_control or cong_avoid.  RTO records are skipped.  The stream
+ * is replayed for a number of passes, each on a freshly initialised
+ * socket, and the time per ACK is reported together with the same harness
+ * driving empty callbacks, so the difference is the cost of the controller
+ * itself.  Cycles, instructions and cache misses per ACK are read from
+ * perf when it is available (-1 otherwise).  -P also times each callback
+ * separately, which perturbs the total.
+ *
+ * tcp_relentless.c is built against the shim in sim/include as for the
+ * simulator, so the numbers are for userspace code generation and a warm
+ * cache; they bound the softirq cost rather than measure it.
+ */
+
+#include <stdio.h>
+#include <getopt.h>
+#include <time.h>
+
+#include "tcp_relentless.c"
+#include "ack_trace.h"
+#include "sim_params.h"
+#include "bench_perf.h"
+
+static struct {
+	const char *ops_name;
+	const char *trace;
+	u32 passes;
+	u32 synth_acks;
+	u32 mss;
+	bool per_callback;
+
+	struct ack_rec *recs;
+	long nrecs;
+	struct tcp_sock tp;
+	u64 timer_ns;		/* cost of one timed region, -P only */
+	u64 cb_ns[3];		/* in_ack_event, pkts_acked, cong_* */
+} bench = {
+	.ops_name = "relentless",
+	.passes = 100,
+	.synth_acks = 100000,
+	.mss = 1448,
+};
+
+static u64 bench_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * 100 Mbit/s with a 20 ms base RTT: one ACK per 1448 byte packet, a queue
+ * that builds from nothing to 10 ms and drains every 2000 ACKs, and a CE
+ * mark when it is over 5 ms.
+ */
+static void bench_synth(void)
+{
+	u32 bdp = 173, i;
+
+	bench.recs = calloc(bench.synth_acks, sizeof(*bench.recs));
+	if (!bench.recs) {
+		fprintf(stderr, "relentless_bench: out of memory\n");
+		exit(1);
+	}
+	for (i = 0; i < bench.synth_acks; i++) {
+		struct ack_rec *r = &bench.recs[i];
+		u32 qdelay = (i % 2000) * 5;
+
+		r->t_us = 20000 + i * 116ULL;
+		r->acked = 1;
+		r->rtt_us = 20000 + qdelay;
+		r->ce = qdelay > 5000;
+		r->in_flight = bdp + qdelay / 116;
+		r->delivered = r->in_flight;
+		r->interval_us = r->rtt_us;
+	}
+	bench.nrecs = bench.synth_acks;
+}
+
+static struct sock *bench_sk(void)
+{
+	return (struct sock *)&bench.tp;
+}
+
+static void bench_reset(const struct tcp_congestion_ops *ops)
+{
+	struct tcp_sock *tp = &bench.tp;
+	struct sock *sk = bench_sk();
+
+	memset(tp, 0, sizeof(*tp));
+	sk->net = &init_net;
+	sk->sk_max_pacing_rate = ~0UL;
+	sk->sk_pacing_shift = 10;
+	inet_csk(sk)->icsk_ca_ops = ops;
+	tp->snd_cwnd = 10;
+	tp->snd_ssthresh = TCP_INFINITE_SSTHRESH;
+	tp->snd_cwnd_clamp = ~0U;
+	tp->mss_cache = bench.mss;
+	tp->snd_nxt = tp->snd_cwnd * bench.mss;
+	tp->packets_out = tp->max_packets_out = tp->snd_cwnd;
+	tp->is_cwnd_limited = true;
+	if (ecn)
+		tp->ecn_flags = TCP_ECN_OK;
+	if (ops->init)
+		ops->init(sk);
+}
+
+/* The stack's side of one ACK: counters, then the ops, then sending */
+static inline void bench_ack_pre(const struct ack_rec *r)
+{
+	struct tcp_sock *tp = &bench.tp;
+
+	tp->tcp_mstamp = r->t_us;
+	tcp_jiffies32 = r->t_us / 1000;
+	tp->snd_una += r->acked * bench.mss;
+	tp->delivered += r->acked;
+	if (r->ce)
+		tp->delivered_ce += r->acked;
+	tp->lost += r->lost;
+	if (r->rtt_us > 0)
+		tp->srtt_us = (u32)r->rtt_us << 3;
+}
+
+static inline void bench_ack_post(void)
+{
+	struct tcp_sock *tp = &bench.tp;
+
+	tp->packets_out = tp->max_packets_out = tp->snd_cwnd;
+	tp->snd_nxt = tp->snd_una + tp->snd_cwnd * bench.mss;
+}
+
+static inline void bench_in_ack_event(const struct tcp_congestion_ops *ops,
+				      const struct ack_rec *r)
+{
+	if (ops->in_ack_event)
+		ops->in_ack_event(bench_sk(), r->ce ? CA_ACK_ECE : 0);
+}
+
+static inline void bench_pkts_acked(const struct tcp_congestion_ops *ops,
+				    const struct ack_rec *r)
+{
+	struct ack_sample sample = {
+		.pkts_acked = r->acked,
+		.rtt_us = r->rtt_us,
+		.in_flight = r->in_flight,
+	};
+
+	if (ops->pkts_acked)
+		ops->pkts_acked(bench_sk(), &sample);
+}
+
+static inline void bench_cong(const struct tcp_congestion_ops *ops,
+			      const struct ack_rec *r)
+{
+	struct tcp_sock *tp = &bench.tp;
+
+	if (ops->cong_control) {
+		struct rate_sample rs = {
+			.prior_delivered = tp->delivered - r->delivered,
+			.delivered = r->delivered,
+			.interval_us = r->interval_us,
+			.rtt_us = r->rtt_us,
+			.losses = r->lost,
+			.acked_sacked = r->acked,
+			.prior_in_flight = r->in_flight,
+		};
+
+		ops->cong_control(bench_sk(), &rs);
+	} else {
+		ops->cong_avoid(bench_sk(), tp->snd_una, r->acked);
+	}
+}
+
+static u64 bench_pass(const struct tcp_congestion_ops *ops)
+{
+	u64 start;
+	long i;
+
+	bench_reset(ops);
+	start = bench_now_ns();
+	for (i = 0; i < bench.nrecs; i++) {
+		const struct ack_rec *r = &bench.recs[i];
+
+		if (r->event != ACK_TRACE_ACK)
+			continue;
+		bench_ack_pre(r);
+		bench_in_ack_event(ops, r);
+		bench_pkts_acked(ops, r);
+		bench_cong(ops, r);
+		bench_ack_post();
+	}
+	return bench_now_ns() - start;
+}
+
+#define BENCH_TIMED(slot, call)					\
+	do {							\
+		u64 t0 = bench_now_ns();			\
+		call;						\
+		bench.cb_ns[slot] += bench_now_ns() - t0;	\
+	} while (0)
+
+static void bench_pass_per_callback(const struct tcp_congestion_ops *ops)
+{
+	long i;
+
+	bench_reset(ops);
+	for (i = 0; i < bench.nrecs; i++) {
+		const struct ack_rec *r = &bench.recs[i];
+
+		if (r->event != ACK_TRACE_ACK)
+			continue;
+		bench_ack_pre(r);
+		BENCH_TIMED(0, bench_in_ack_event(ops, r));
+		BENCH_TIMED(1, bench_pkts_acked(ops, r));
+		BENCH_TIMED(2, bench_cong(ops, r));
+		bench_ack_post();
+	}
+}
+
+static void bench_calibrate_timer(void)
+{
+	u64 t0, sum = 0;
+	u32 i, n = 1000000;
+
+	for (i = 0; i < n; i++) {
+		t0 = bench_now_ns();
+		sum += bench_now_ns() - t0;
+	}
+	bench.timer_ns = sum / n;
+}
+
+/* Empty callbacks, for the cost of the harness and the indirect calls */
+static void bench_noop_init(struct sock *sk) { }
+static void bench_noop_in_ack_event(struct sock *sk, u32 flags) { }
+static void bench_noop_pkts_acked(struct sock *sk, const struct ack_sample *sample) { }
+static void bench_noop_cong_avoid(struct sock *sk, u32 ack, u32 acked) { }
+static void bench_noop_cong_control(struct sock *sk, const struct rate_sample *rs) { }
+
+static void bench_noop_ops(struct tcp_congestion_ops *noop,
+			   const struct tcp_congestion_ops *ops)
+{
+	memset(noop, 0, sizeof(*noop));
+	noop->init = bench_noop_init;
+	if (ops->in_ack_event)
+		noop->in_ack_event = bench_noop_in_ack_event;
+	if (ops->pkts_acked)
+		noop->pkts_acked = bench_noop_pkts_acked;
+	if (ops->cong_control)
+		noop->cong_control = bench_noop_cong_control;
+	else
+		noop->cong_avoid = bench_noop_cong_avoid;
+}
+
+static double bench_per_ack(long long v, u64 acks)
+{
+	return v < 0 ? -1 : (double)v / acks;
+}
+
+static void bench_usage(void)
+{
+	fprintf(stderr,
+		"usage: relentless_bench [options]\n"
+		"  -c, --cc NAME          relentless or relentless_rate (relentless)\n"
+		"  -f, --trace FILE       ACK trace to replay, see ack_trace.h (synthetic)\n"
+		"  -a, --acks N           length of the synthetic trace (100000)\n"
+		"  -n, --passes N         replays of the trace (100)\n"
+		"  -m, --mss BYTES        (1448)\n"
+		"  -P, --per-callback     also time each callback\n"
+		"  -p, --param NAME=VAL   set a module parameter:\n");
+	sim_params_usage(stderr);
+}
+
+int main(int argc, char **argv)
+{
+	static const struct option opts[] = {
+		{ "cc", required_argument, NULL, 'c' },
+		{ "trace", required_argument, NULL, 'f' },
+		{ "acks", required_argument, NULL, 'a' },
+		{ "passes", required_argument, NULL, 'n' },
+		{ "mss", required_argument, NULL, 'm' },
+		{ "per-callback", no_argument, NULL, 'P' },
+		{ "param", required_argument, NULL, 'p' },
+		{ "help", no_argument, NULL, 'h' },
+		{ }
+	};
+	const struct tcp_congestion_ops *ops;
+	struct tcp_congestion_ops noop;
+	long long counters[BENCH_PERF_NR];
+	struct bench_perf perf;
+	u64 ns = 0, noop_ns = 0, acks;
+	u32 i;
+	int c;
+
+	while ((c = getopt_long(argc, argv, "c:f:a:n:m:Pp:h", opts, NULL)) != -1) {
+		switch (c) {
+		case 'c': bench.ops_name = optarg; break;
+		case 'f': bench.trace = optarg; break;
+		case 'a': bench.synth_acks = strtoul(optarg, NULL, 0); break;
+		case 'n': bench.passes = strtoul(optarg, NULL, 0); break;
+		case 'm': bench.mss = strtoul(optarg, NULL, 0); break;
+		case 'P': bench.per_callback = true; break;
+		case 'p':
+			if (sim_set_param(optarg)) {
+				fprintf(stderr, "relentless_bench: unknown parameter %s\n", optarg);
+				return 1;
+			}
+			break;
+		default:
+			bench_usage();
+			return c == 'h' ? 0 : 1;
+		}
+	}
+
+	if (optind != argc || !bench.passes || !bench.mss ||
+	    (!bench.trace && !bench.synth_acks)) {
+		bench_usage();
+		return 1;
+	}
+
+	if (bench.trace) {
+		FILE *f = fopen(bench.trace, "r");
+
+		if (!f) {
+			perror(bench.trace);
+			return 1;
+		}
+		bench.nrecs = ack_trace_read(f, &bench.recs);
+		fclose(f);
+		if (bench.nrecs <= 0) {
+			fprintf(stderr, "relentless_bench: %s: not an ACK trace\n", bench.trace);
+			return 1;
+		}
+	} else {
+		bench_synth();
+	}
+
+	if (relentless_register()) {
+		fprintf(stderr, "relentless_bench: module init failed\n");
+		return 1;
+	}
+	ops = sim_find_congestion_control(bench.ops_name);
+	if (!ops) {
+		fprintf(stderr, "relentless_bench: no congestion control %s\n", bench.ops_name);
+		return 1;
+	}
+	bench_noop_ops(&noop, ops);
+
+	/* warm the caches and branch predictors */
+	bench_pass(&noop);
+	bench_pass(ops);
+
+	for (i = 0; i < bench.passes; i++)
+		noop_ns += bench_pass(&noop);
+
+	bench_perf_open(&perf);
+	bench_perf_start(&perf);
+	for (i = 0; i < bench.passes; i++)
+		ns += bench_pass(ops);
+	bench_perf_stop(&perf, counters);
+	bench_perf_close(&perf);
+
+	acks = (u64)bench.nrecs * bench.passes;
+	printf("ops=%s acks=%ld passes=%u ns_per_ack=%.2f harness_ns_per_ack=%.2f"
+	       " cycles_per_ack=%.1f instructions_per_ack=%.1f cache_misses_per_ack=%.4f"
+	       " final_cwnd=%u",
+	       ops->name, bench.nrecs, bench.passes, (double)ns / acks,
+	       (double)noop_ns / acks,
+	       bench_per_ack(counters[BENCH_PERF_CYCLES], acks),
+	       bench_per_ack(counters[BENCH_PERF_INSTRUCTIONS], acks),
+	       bench_per_ack(counters[BENCH_PERF_CACHE_MISSES], acks),
+	       bench.tp.snd_cwnd);
+
+	if (bench.per_callback) {
+		bench_calibrate_timer();
+		for (i = 0; i < bench.passes; i++)
+			bench_pass_per_callback(ops);
+		printf(" in_ack_event_ns=%.2f pkts_acked_ns=%.2f %s_ns=%.2f timer_ns=%llu",
+		       max((double)bench.cb_ns[0] / acks - bench.timer_ns, 0.0),
+		       max((double)bench.cb_ns[1] / acks - bench.timer_ns, 0.0),
+		       ops->cong_control ? "cong_control" : "cong_avoid",
+		       max((double)bench.cb_ns[2] / acks - bench.timer_ns, 0.0),
+		       (unsigned long long)bench.timer_ns);
+	}
+	printf("\n");
+
+	relentless_unregister();
+	free(bench.recs);
+	return 0;
+}
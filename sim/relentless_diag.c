@@ -0,0 +1,164 @@
+/*
+ * Print the Relentless TCP state of the local TCP sockets using it.
+ *
+ *	relentless_diag [-p port]
+ *
+ * ss -ti drops the module's INET_DIAG_RELENTLESSINFO attribute, being
+ * above the upstream INET_DIAG_* range, so this dumps the IPv4 and IPv6
+ * TCP sockets over NETLINK_SOCK_DIAG itself.  It asks for
+ * INET_DIAG_VEGASINFO, which relentless_get_info() answers with struct
+ * tcp_relentless_info, and prints one line per socket that returned it,
+ * optionally only those with the given local or remote port.  rtt_cwnd is
+ * the controller's window in packets (the attribute carries it scaled by
+ * 1024); the RTTs are in usecs and the counters saturate at 65535.
+ */
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <linux/inet_diag.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/sock_diag.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "tcp_relentless.h"
+
+static int filter_port = -1;
+
+static void print_sock(const struct inet_diag_msg *m,
+		       const struct tcp_relentless_info *ri)
+{
+	char src[INET6_ADDRSTRLEN], dst[INET6_ADDRSTRLEN];
+	unsigned int sport = ntohs(m->id.idiag_sport);
+	unsigned int dport = ntohs(m->id.idiag_dport);
+
+	inet_ntop(m->idiag_family, m->id.idiag_src, src, sizeof(src));
+	inet_ntop(m->idiag_family, m->id.idiag_dst, dst, sizeof(dst));
+	printf(m->idiag_family == AF_INET6 ? "[%s]:%u [%s]:%u" : "%s:%u %s:%u",
+	       src, sport, dst, dport);
+	printf(" rtt_min %u rtt_thresh %u rtt_cwnd %u.%03u save_cwnd %u"
+	       " rtts_observed %u backoffs %u\n",
+	       ri->relentless_rtt_min, ri->relentless_rtt_thresh,
+	       ri->relentless_rtt_cwnd >> 10,
+	       (ri->relentless_rtt_cwnd & 1023) * 1000 / 1024,
+	       ri->relentless_save_cwnd, ri->relentless_rtts_observed,
+	       ri->relentless_backoffs);
+}
+
+static void parse_sock(const struct nlmsghdr *nlh)
+{
+	const struct inet_diag_msg *m = NLMSG_DATA(nlh);
+	struct tcp_relentless_info ri;
+	const struct rtattr *rta;
+	int len;
+
+	if (nlh->nlmsg_len < NLMSG_LENGTH(sizeof(*m)))
+		return;
+	if (filter_port >= 0 && ntohs(m->id.idiag_sport) != filter_port &&
+	    ntohs(m->id.idiag_dport) != filter_port)
+		return;
+
+	len = nlh->nlmsg_len - NLMSG_LENGTH(sizeof(*m));
+	for (rta = (const struct rtattr *)(m + 1); RTA_OK(rta, len);
+	     rta = RTA_NEXT(rta, len)) {
+		if ((rta->rta_type & NLA_TYPE_MASK) != INET_DIAG_RELENTLESSINFO ||
+		    RTA_PAYLOAD(rta) < sizeof(ri))
+			continue;
+		memcpy(&ri, RTA_DATA(rta), sizeof(ri));
+		print_sock(m, &ri);
+		return;
+	}
+}
+
+static int dump_family(int fd, int family)
+{
+	struct {
+		struct nlmsghdr nlh;
+		struct inet_diag_req_v2 req;
+	} msg = {
+		.nlh = {
+			.nlmsg_len = sizeof(msg),
+			.nlmsg_type = SOCK_DIAG_BY_FAMILY,
+			.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP,
+		},
+		.req = {
+			.sdiag_family = family,
+			.sdiag_protocol = IPPROTO_TCP,
+			.idiag_ext = 1 << (INET_DIAG_VEGASINFO - 1),
+			.idiag_states = ~0U,
+		},
+	};
+	struct sockaddr_nl nladdr = { .nl_family = AF_NETLINK };
+	static char buf[32768];
+	struct nlmsghdr *nlh;
+	ssize_t n;
+
+	if (sendto(fd, &msg, sizeof(msg), 0, (struct sockaddr *)&nladdr,
+		   sizeof(nladdr)) < 0) {
+		perror("relentless_diag: sendto");
+		return -1;
+	}
+
+	for (;;) {
+		n = recv(fd, buf, sizeof(buf), 0);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("relentless_diag: recv");
+			return -1;
+		}
+		for (nlh = (struct nlmsghdr *)buf; NLMSG_OK(nlh, n);
+		     nlh = NLMSG_NEXT(nlh, n)) {
+			if (nlh->nlmsg_type == NLMSG_DONE)
+				return 0;
+			if (nlh->nlmsg_type == NLMSG_ERROR) {
+				const struct nlmsgerr *err = NLMSG_DATA(nlh);
+
+				fprintf(stderr, "relentless_diag: %s dump: %s\n",
+					family == AF_INET6 ? "IPv6" : "IPv4",
+					strerror(-err->error));
+				return -1;
+			}
+			if (nlh->nlmsg_type == SOCK_DIAG_BY_FAMILY)
+				parse_sock(nlh);
+		}
+	}
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: relentless_diag [-p port]\n");
+}
+
+int main(int argc, char **argv)
+{
+	int c, fd, ret = 0;
+
+	while ((c = getopt(argc, argv, "p:h")) != -1) {
+		switch (c) {
+		case 'p': filter_port = strtoul(optarg, NULL, 0); break;
+		default:
+			usage();
+			return c == 'h' ? 0 : 1;
+		}
+	}
+	if (optind != argc) {
+		usage();
+		return 1;
+	}
+
+	fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+	if (fd < 0) {
+		perror("relentless_diag: socket");
+		return 1;
+	}
+	if (dump_family(fd, AF_INET) || dump_family(fd, AF_INET6))
+		ret = 1;
+	close(fd);
+	return ret;
+}
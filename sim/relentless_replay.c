@@ -0,0 +1,434 @@
+/*
+ * Relentless TCP trace replay.
+ *
+ * Feeds a recorded ACK stream (an ack_trace.h trace, from relentless_sim
+ * -R, pcap2ack or tcp_probe2ack.sh) through the congestion ops and prints
+ * the controller's cwnd, ssthresh, rtt_cwnd, rtt_min and rtt_thresh as a
+ * timeline, so a field incident can be rerun with different module
+ * parameters (-p) deterministically.
+ *
+ * The replay is open loop: ACK arrivals, RTT samples, CE marks, losses and
+ * RTOs come from the trace, not from the window being computed.  Around
+ * the ops it runs the same reduced CA state machine as relentless_sim,
+ * entering Recovery on newly lost packets, CWR on CE with ecn=1 and Loss
+ * on an RTO record, with PRR while reducing, and leaving when the data
+ * outstanding at entry has been acked.  Lost packets are assumed to be
+ * retransmitted at once, except in Loss where cwnd paces them, and the
+ * connection cwnd limited unless -a.
+ */
+
+#include <stdio.h>
+#include <getopt.h>
+
+#include "tcp_relentless.c"
+#include "ack_trace.h"
+#include "sim_params.h"
+
+static struct {
+	const char *ops_name;
+	const char *trace;
+	u32 mss;
+	double interval_ms;
+	bool summary;
+	bool app_limited;	/* cwnd limited only while in_flight >= cwnd */
+
+	const struct tcp_congestion_ops *ops;
+	struct tcp_sock tp;
+	u32 high;		/* snd_nxt at the start of a reduction */
+	u32 retransmits;	/* RTOs since snd_una last moved, icsk_retransmits */
+	u32 prr_delivered, prr_out;
+	u64 next_print_us;
+
+	/* summary */
+	u64 acks;
+	double cwnd_sum;
+	u32 cwnd_min, cwnd_max;
+	u32 recoveries, cwrs, rtos;
+} rp = {
+	.ops_name = "relentless",
+	.mss = 1448,
+	.cwnd_min = ~0U,
+};
+
+static const char *const rp_state_names[] = {
+	[TCP_CA_Open] = "open",
+	[TCP_CA_Disorder] = "disorder",
+	[TCP_CA_CWR] = "cwr",
+	[TCP_CA_Recovery] = "recovery",
+	[TCP_CA_Loss] = "loss",
+};
+
+static struct sock *rp_sk(void)
+{
+	return (struct sock *)&rp.tp;
+}
+
+static u8 rp_state(void)
+{
+	return inet_csk(rp_sk())->icsk_ca_state;
+}
+
+static void rp_set_state(u8 state)
+{
+	if (rp.ops->set_state)
+		rp.ops->set_state(rp_sk(), state);
+	inet_csk(rp_sk())->icsk_ca_state = state;
+}
+
+static void rp_cwnd_event(enum tcp_ca_event event)
+{
+	if (rp.ops->cwnd_event)
+		rp.ops->cwnd_event(rp_sk(), event);
+}
+
+static void rp_init(void)
+{
+	struct tcp_sock *tp = &rp.tp;
+	struct sock *sk = rp_sk();
+
+	sk->net = &init_net;
+	sk->sk_max_pacing_rate = ~0UL;
+	sk->sk_pacing_shift = 10;
+	inet_csk(sk)->icsk_ca_ops = rp.ops;
+	tp->snd_cwnd = 10;
+	tp->snd_ssthresh = TCP_INFINITE_SSTHRESH;
+	tp->snd_cwnd_clamp = ~0U;
+	tp->mss_cache = rp.mss;
+	if (ecn)
+		tp->ecn_flags = TCP_ECN_OK;
+	rp.ops->init(sk);
+}
+
+static void rp_init_cwnd_reduction(void)
+{
+	struct tcp_sock *tp = &rp.tp;
+
+	rp.high = tp->snd_nxt;
+	tp->prior_cwnd = tp->snd_cwnd;
+	tp->prior_ssthresh = tp->snd_ssthresh;
+	rp.prr_delivered = 0;
+	rp.prr_out = 0;
+	tp->snd_ssthresh = rp.ops->ssthresh(rp_sk());
+}
+
+static void rp_end_cwnd_reduction(void)
+{
+	struct tcp_sock *tp = &rp.tp;
+
+	if (rp.ops->cong_control)
+		return;
+
+	if (tp->snd_ssthresh < TCP_INFINITE_SSTHRESH)
+		tp->snd_cwnd = tp->snd_ssthresh;
+	rp_cwnd_event(CA_EVENT_COMPLETE_CWR);
+}
+
+/* Proportional rate reduction, as in relentless_sim */
+static void rp_prr(u32 newly_acked, u32 newly_lost)
+{
+	struct tcp_sock *tp = &rp.tp;
+	int delta = tp->snd_ssthresh - tcp_packets_in_flight(tp);
+	int sndcnt;
+
+	if (!newly_acked || !tp->prior_cwnd)
+		return;
+
+	rp.prr_delivered += newly_acked;
+	if (delta < 0) {
+		u64 dividend = (u64)tp->snd_ssthresh * rp.prr_delivered + tp->prior_cwnd - 1;
+
+		sndcnt = dividend / tp->prior_cwnd - rp.prr_out;
+	} else {
+		sndcnt = max((int)(rp.prr_delivered - rp.prr_out), (int)newly_acked);
+		if (!newly_lost)
+			sndcnt++;
+		sndcnt = min(delta, sndcnt);
+	}
+	sndcnt = max(sndcnt, rp.prr_out ? 0 : 1);
+	rp.prr_out += sndcnt;
+	tp->snd_cwnd = tcp_packets_in_flight(tp) + sndcnt;
+}
+
+static void rp_ca_state(bool ce)
+{
+	struct tcp_sock *tp = &rp.tp;
+	bool done = !before(tp->snd_una, rp.high);
+
+	switch (rp_state()) {
+	case TCP_CA_Open:
+	case TCP_CA_Disorder:
+		if (tp->lost_out) {
+			rp_init_cwnd_reduction();
+			rp_set_state(TCP_CA_Recovery);
+			rp.recoveries++;
+		} else if (ce && (tp->ecn_flags & TCP_ECN_OK)) {
+			rp_init_cwnd_reduction();
+			rp_set_state(TCP_CA_CWR);
+			rp.cwrs++;
+		}
+		break;
+
+	case TCP_CA_CWR:
+		if (tp->lost_out) {
+			rp.high = tp->snd_nxt;
+			rp_set_state(TCP_CA_Recovery);
+			rp.recoveries++;
+		} else if (done) {
+			rp_end_cwnd_reduction();
+			rp_set_state(TCP_CA_Open);
+		}
+		break;
+
+	case TCP_CA_Recovery:
+		if (done) {
+			tp->lost_out = tp->retrans_out = 0;
+			rp_end_cwnd_reduction();
+			rp_set_state(TCP_CA_Open);
+		}
+		break;
+
+	case TCP_CA_Loss:
+		if (done) {
+			tp->lost_out = tp->retrans_out = 0;
+			rp_set_state(TCP_CA_Open);
+		}
+		break;
+	}
+}
+
+/* In Loss the lost packets go out as cwnd allows, not all at once */
+static void rp_loss_xmit(void)
+{
+	struct tcp_sock *tp = &rp.tp;
+	u32 in_flight = tp->packets_out - tp->lost_out;
+
+	if (rp_state() != TCP_CA_Loss)
+		return;
+	tp->retrans_out = min(tp->lost_out, tp->snd_cwnd - min(tp->snd_cwnd, in_flight));
+}
+
+/* tcp_enter_loss(), with everything outstanding marked lost */
+static void rp_rto(const struct ack_rec *r)
+{
+	struct tcp_sock *tp = &rp.tp;
+	u8 state = rp_state();
+
+	rp.rtos++;
+	tp->packets_out = r->in_flight;
+	tp->snd_nxt = tp->snd_una + r->in_flight * rp.mss;
+	tp->lost += r->lost;
+	tp->lost_out = tp->packets_out;
+	tp->retrans_out = 0;
+
+	if (state <= TCP_CA_Disorder || !before(tp->snd_una, rp.high) ||
+	    (state == TCP_CA_Loss && !rp.retransmits)) {
+		tp->prior_ssthresh = tp->snd_ssthresh;
+		tp->prior_cwnd = tp->snd_cwnd;
+		tp->snd_ssthresh = rp.ops->ssthresh(rp_sk());
+		rp_cwnd_event(CA_EVENT_LOSS);
+	}
+	tp->snd_cwnd = tcp_packets_in_flight(tp) + 1;
+	tp->snd_cwnd_cnt = 0;
+	rp_set_state(TCP_CA_Loss);
+	rp.high = tp->snd_nxt;
+	rp.retransmits++;
+	rp_loss_xmit();
+}
+
+static void rp_ack(const struct ack_rec *r)
+{
+	struct tcp_sock *tp = &rp.tp;
+	struct sock *sk = rp_sk();
+	u32 prior_delivered = tp->delivered;
+	s32 rtt_us = r->rtt_us;
+
+	tp->packets_out = r->in_flight;
+	tp->snd_nxt = tp->snd_una + r->in_flight * rp.mss;
+	tp->is_cwnd_limited = !rp.app_limited || r->in_flight >= tp->snd_cwnd;
+	tp->max_packets_out = rp.app_limited ? r->in_flight : tp->snd_cwnd;
+
+	/* lost packets are retransmitted at once, see the top of the file */
+	tp->lost += r->lost;
+	tp->lost_out += r->lost;
+	tp->retrans_out += r->lost;
+
+	if (rp.ops->in_ack_event)
+		rp.ops->in_ack_event(sk, r->ce ? CA_ACK_ECE : 0);
+
+	if (r->acked)
+		rp.retransmits = 0;
+	tp->snd_una += r->acked * rp.mss;
+	tp->delivered += r->acked;
+	if (r->ce)
+		tp->delivered_ce += r->acked;
+	tp->packets_out -= min(r->acked, tp->packets_out);
+	tp->lost_out = min(tp->lost_out, tp->packets_out);
+	tp->retrans_out = min(tp->retrans_out, tp->lost_out);
+	if (rtt_us > 0)
+		tp->srtt_us = tp->srtt_us ? tp->srtt_us - (tp->srtt_us >> 3) + rtt_us
+					  : (u32)rtt_us << 3;
+
+	if (rp.ops->pkts_acked && r->acked) {
+		struct ack_sample sample = {
+			.pkts_acked = r->acked,
+			.rtt_us = rtt_us,
+			.in_flight = r->in_flight,
+		};
+
+		rp.ops->pkts_acked(sk, &sample);
+	}
+
+	rp_ca_state(r->ce);
+
+	if (rp.ops->cong_control) {
+		struct rate_sample rs = {
+			.prior_delivered = prior_delivered,
+			.delivered = r->delivered,
+			.interval_us = r->interval_us,
+			.rtt_us = rtt_us,
+			.losses = r->lost,
+			.acked_sacked = r->acked,
+			.prior_in_flight = r->in_flight,
+		};
+
+		rp.ops->cong_control(sk, &rs);
+	} else if (tcp_in_cwnd_reduction(sk)) {
+		rp_prr(r->acked, r->lost);
+	} else {
+		rp.ops->cong_avoid(sk, tp->snd_una, r->acked);
+	}
+	rp_loss_xmit();
+}
+
+static void rp_print(u64 t_us)
+{
+	const struct tcp_sock *tp = &rp.tp;
+	const struct relentless *ca = inet_csk_ca(rp_sk());
+
+	printf("%.3f %u %u %.2f %u %u %s\n", t_us / 1000.0, tp->snd_cwnd,
+	       tp->snd_ssthresh, (double)ca->rtt_cwnd / RELENTLESS_CWND_ONE,
+	       minmax_get(&ca->rtt_min), ca->rtt_thresh,
+	       rp_state_names[rp_state()]);
+}
+
+static void rp_usage(void)
+{
+	fprintf(stderr,
+		"usage: relentless_replay [options]\n"
+		"  -c, --cc NAME          relentless or relentless_rate (relentless)\n"
+		"  -f, --trace FILE       ACK trace, see ack_trace.h (stdin)\n"
+		"  -m, --mss BYTES        (1448)\n"
+		"  -i, --interval MS      print at most once per interval (0, every record)\n"
+		"  -a, --app-limited      cwnd limited only while in_flight >= cwnd\n"
+		"  -s, --summary          print a summary line instead of the timeline\n"
+		"  -p, --param NAME=VAL   set a module parameter:\n");
+	sim_params_usage(stderr);
+}
+
+int main(int argc, char **argv)
+{
+	static const struct option opts[] = {
+		{ "cc", required_argument, NULL, 'c' },
+		{ "trace", required_argument, NULL, 'f' },
+		{ "mss", required_argument, NULL, 'm' },
+		{ "interval", required_argument, NULL, 'i' },
+		{ "app-limited", no_argument, NULL, 'a' },
+		{ "summary", no_argument, NULL, 's' },
+		{ "param", required_argument, NULL, 'p' },
+		{ "help", no_argument, NULL, 'h' },
+		{ }
+	};
+	struct ack_rec *recs;
+	long nrecs, i;
+	FILE *f = stdin;
+	int c;
+
+	while ((c = getopt_long(argc, argv, "c:f:m:i:asp:h", opts, NULL)) != -1) {
+		switch (c) {
+		case 'c': rp.ops_name = optarg; break;
+		case 'f': rp.trace = optarg; break;
+		case 'm': rp.mss = strtoul(optarg, NULL, 0); break;
+		case 'i': rp.interval_ms = atof(optarg); break;
+		case 'a': rp.app_limited = true; break;
+		case 's': rp.summary = true; break;
+		case 'p':
+			if (sim_set_param(optarg)) {
+				fprintf(stderr, "relentless_replay: unknown parameter %s\n", optarg);
+				return 1;
+			}
+			break;
+		default:
+			rp_usage();
+			return c == 'h' ? 0 : 1;
+		}
+	}
+	if (optind != argc || !rp.mss || rp.interval_ms < 0) {
+		rp_usage();
+		return 1;
+	}
+
+	if (rp.trace && strcmp(rp.trace, "-")) {
+		f = fopen(rp.trace, "r");
+		if (!f) {
+			perror(rp.trace);
+			return 1;
+		}
+	}
+	nrecs = ack_trace_read(f, &recs);
+	if (f != stdin)
+		fclose(f);
+	if (nrecs < 0) {
+		fprintf(stderr, "relentless_replay: %s: not an ACK trace\n",
+			rp.trace ? rp.trace : "stdin");
+		return 1;
+	}
+
+	if (relentless_register()) {
+		fprintf(stderr, "relentless_replay: module init failed\n");
+		return 1;
+	}
+	rp.ops = sim_find_congestion_control(rp.ops_name);
+	if (!rp.ops) {
+		fprintf(stderr, "relentless_replay: no congestion control %s\n", rp.ops_name);
+		return 1;
+	}
+
+	rp_init();
+	if (!rp.summary)
+		printf("# t_ms cwnd ssthresh rtt_cwnd rtt_min_us rtt_thresh_us state\n");
+	for (i = 0; i < nrecs; i++) {
+		const struct ack_rec *r = &recs[i];
+
+		rp.tp.tcp_mstamp = r->t_us;
+		tcp_jiffies32 = r->t_us / 1000;
+		if (r->event == ACK_TRACE_RTO) {
+			rp_rto(r);
+		} else {
+			rp_ack(r);
+			rp.acks++;
+			rp.cwnd_sum += rp.tp.snd_cwnd;
+			rp.cwnd_min = min(rp.cwnd_min, rp.tp.snd_cwnd);
+			rp.cwnd_max = max(rp.cwnd_max, rp.tp.snd_cwnd);
+		}
+		if (!rp.summary && r->t_us >= rp.next_print_us) {
+			rp_print(r->t_us);
+			rp.next_print_us = r->t_us + rp.interval_ms * 1000;
+		}
+	}
+
+	if (rp.summary) {
+		const struct relentless *ca = inet_csk_ca(rp_sk());
+
+		printf("ops=%s acks=%llu duration_ms=%.3f cwnd_mean=%.2f cwnd_min=%u"
+		       " cwnd_max=%u final_cwnd=%u recoveries=%u cwrs=%u rtos=%u backoffs=%u\n",
+		       rp.ops->name, (unsigned long long)rp.acks,
+		       nrecs ? (recs[nrecs - 1].t_us - recs[0].t_us) / 1000.0 : 0,
+		       rp.acks ? rp.cwnd_sum / rp.acks : 0,
+		       rp.acks ? rp.cwnd_min : 0, rp.cwnd_max, rp.tp.snd_cwnd,
+		       rp.recoveries, rp.cwrs, rp.rtos, ca->backoffs);
+	}
+
+	relentless_unregister();
+	free(recs);
+	return 0;
+}
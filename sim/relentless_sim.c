@@ -0,0 +1,1179 @@
+/*
+ * Relentless TCP simulator.
+ *
+ * tcp_relentless.c is built unchanged against the shim in sim/include, and
+ * its congestion ops drive bulk flows through a discrete event model of one
+ * FIFO bottleneck: a link of the given rate with a drop tail buffer, random
+ * loss, an optional ECN marking threshold, and the base RTT as pure
+ * propagation delay.  The sender follows the kernel's order of calls on
+ * each ACK (in_ack_event, pkts_acked, the CA state machine, then
+ * cong_control, or PRR in CWR/Recovery and cong_avoid otherwise), with
+ * SACK and RACK style loss detection and an RTO timer.  Every data packet
+ * is acked on its own, so there are no delayed or stretch ACKs.
+ *
+ * Results are one line of key=value pairs, so sweeps are shell loops; see
+ * sweep.sh.  -R records the first flow's ACKs and RTOs as an ack_trace.h
+ * trace.  Build with "make sim".
+ */
+
+#include <stdio.h>
+#include <getopt.h>
+#include <math.h>
+
+#include "tcp_relentless.c"
+#include "ack_trace.h"
+#include "sim_params.h"
+
+#define NSEC_PER_USEC	1000ULL
+#define NSEC_PER_MSEC	1000000ULL
+#define NSEC_PER_SEC	1000000000ULL
+
+#define SIM_MAX_FLOWS	64
+#define SIM_RTO_MIN_NS	(200 * NSEC_PER_MSEC)
+#define SIM_RTO_MAX_NS	(120 * NSEC_PER_SEC)
+
+/* Queueing delay histogram, 10us bins up to 10s */
+#define SIM_HIST_BIN_NS	(10 * NSEC_PER_USEC)
+#define SIM_HIST_BINS	1000000U
+
+enum sim_event_type {
+	EV_START,	/* flow starts sending */
+	EV_DEPART,	/* bottleneck finished serving its head packet */
+	EV_ACK,		/* ACK for one packet reaches its sender */
+	EV_SEND,	/* pacing timer */
+	EV_RTO,		/* retransmission timer */
+	EV_SAMPLE,	/* statistics interval */
+};
+
+struct sim_event {
+	u64 t;
+	u64 order;	/* FIFO among events at the same time */
+	u64 tx_ns;	/* EV_ACK: when the acked copy was sent */
+	u32 pkt;
+	u16 flow;
+	u8 type;
+	u8 ce;
+};
+
+#define PKT_DELIVERED	0x1
+#define PKT_LOST	0x2
+#define PKT_RETRANS	0x4
+
+struct sim_pkt {
+	u64 first_tx_ns;
+	u64 tx_ns;		/* latest transmission */
+	u64 prior_delivered_ns;	/* delivery rate sample start, as in tcp_rate.c */
+	u32 prior_delivered;
+	u8 flags;
+};
+
+/* FIFO of packet numbers, with the transmit time they were queued for */
+struct sim_fifo_ent {
+	u32 pkt;
+	u64 tx_ns;
+};
+
+struct sim_fifo {
+	struct sim_fifo_ent *e;
+	u32 head, tail, cap;	/* cap is a power of 2 */
+};
+
+struct sim_flow {
+	struct tcp_sock tp;	/* first, the module casts it to a struct sock */
+	const struct tcp_congestion_ops *ops;
+
+	struct sim_pkt *pkts;	/* packets una..nxt-1, indexed modulo cap */
+	u32 cap;
+	u32 una, nxt;		/* packet numbers, snd_una and snd_nxt / mss */
+	u32 rack_next;		/* originals below this are delivered or lost */
+	u32 high;		/* packet number ending CWR, Recovery or Loss */
+	struct sim_fifo lostq;	/* marked lost, awaiting retransmission */
+	struct sim_fifo rtxq;	/* retransmissions in send order */
+	u32 prr_delivered, prr_out;
+	u64 delivered_ns;
+
+	u64 next_tx_ns;		/* pacing */
+	bool tx_timer;
+	u64 srtt_ns, rttvar_ns;
+	u64 rto_deadline;
+	u32 rto_backoff;
+	bool rto_armed;
+
+	bool started;
+	u64 start_ns;		/* of the current transfer */
+	u32 end;		/* packet number ending it, with -z */
+	u64 bytes;		/* delivered after warmup */
+	u64 interval_bytes;
+	u32 rtos;
+};
+
+struct sim_qent {
+	u64 enq_ns;
+	u64 tx_ns;
+	u32 pkt;
+	u16 flow;
+	u8 ce;
+};
+
+static struct {
+	/* configuration */
+	const char *ops_name;
+	double rate_mbps;
+	double rtt_ms;
+	u32 buffer;		/* packets, 0 means one BDP */
+	double loss;
+	double jitter_p;	/* fraction of RTT samples inflated, */
+	double jitter_us;	/* by up to this much */
+	u32 ecn_k;		/* mark CE at this queue length, 0 disables */
+	u32 nflows;
+	double stagger_ms;
+	double duration_s;
+	double warmup_s;
+	double interval_ms;
+	double jain_target;
+	double hold_ms;
+	u32 mss;
+	u64 seed;
+	u32 size;		/* packets per transfer, 0 for bulk flows */
+	double gap_ms;		/* between a flow's transfers */
+	bool timeline;
+	bool counters;		/* dump /proc/net/relentless at the end */
+	FILE *record;		/* ACK trace of flow 0 */
+
+	/* model */
+	u64 now;
+	u64 service_ns;
+	u64 rtt_ns;
+	struct sim_event *heap;
+	u32 nevents, heap_cap;
+	u64 order;
+
+	struct sim_qent *q;
+	u32 qhead, qlen, qcap;
+	bool busy;
+
+	struct sim_flow flows[SIM_MAX_FLOWS];
+
+	/* results */
+	u64 warmup_ns;
+	u64 busy_ns;
+	u64 sent, dropped;
+	u32 *hist;
+	u64 hist_n;
+	double qdelay_sum;
+	double *fct;		/* transfer completion times, ms */
+	u64 nfct, fct_cap;
+	u64 last_start_ns;
+	u64 jain_since;
+	bool jain_ok;
+	s64 converge_ns;
+	double jain_last;
+} sim = {
+	.ops_name = "relentless",
+	.rate_mbps = 100,
+	.rtt_ms = 20,
+	.nflows = 1,
+	.duration_s = 30,
+	.warmup_s = 2,
+	.interval_ms = 100,
+	.jain_target = 0.9,
+	.hold_ms = 1000,
+	.mss = 1448,
+	.gap_ms = 100,
+	.seed = 1,
+	.converge_ns = -1,
+};
+
+static void *sim_zalloc(size_t size)
+{
+	void *p = calloc(1, size);
+
+	if (!p) {
+		fprintf(stderr, "relentless_sim: out of memory\n");
+		exit(1);
+	}
+	return p;
+}
+
+static double sim_random(void)
+{
+	/* xorshift64* */
+	sim.seed ^= sim.seed >> 12;
+	sim.seed ^= sim.seed << 25;
+	sim.seed ^= sim.seed >> 27;
+	return (double)((sim.seed * 2685821657736338717ULL) >> 11) / (double)(1ULL << 53);
+}
+
+static bool sim_event_less(const struct sim_event *a, const struct sim_event *b)
+{
+	return a->t < b->t || (a->t == b->t && a->order < b->order);
+}
+
+static void sim_schedule(struct sim_event ev)
+{
+	u32 i;
+
+	if (sim.nevents == sim.heap_cap) {
+		sim.heap_cap = sim.heap_cap ? sim.heap_cap * 2 : 1024;
+		sim.heap = realloc(sim.heap, sim.heap_cap * sizeof(*sim.heap));
+		if (!sim.heap) {
+			fprintf(stderr, "relentless_sim: out of memory\n");
+			exit(1);
+		}
+	}
+
+	ev.order = sim.order++;
+	for (i = sim.nevents++; i; i = (i - 1) / 2) {
+		struct sim_event *parent = &sim.heap[(i - 1) / 2];
+
+		if (!sim_event_less(&ev, parent))
+			break;
+		sim.heap[i] = *parent;
+	}
+	sim.heap[i] = ev;
+}
+
+static struct sim_event sim_next_event(void)
+{
+	struct sim_event top = sim.heap[0], last = sim.heap[--sim.nevents];
+	u32 i = 0, child;
+
+	while ((child = 2 * i + 1) < sim.nevents) {
+		if (child + 1 < sim.nevents &&
+		    sim_event_less(&sim.heap[child + 1], &sim.heap[child]))
+			child++;
+		if (!sim_event_less(&sim.heap[child], &last))
+			break;
+		sim.heap[i] = sim.heap[child];
+		i = child;
+	}
+	sim.heap[i] = last;
+	return top;
+}
+
+static void sim_fifo_push(struct sim_fifo *f, u32 pkt, u64 tx_ns)
+{
+	if (f->tail - f->head == f->cap) {
+		u32 cap = f->cap ? f->cap * 2 : 64, i;
+		struct sim_fifo_ent *e = sim_zalloc(cap * sizeof(*e));
+
+		for (i = f->head; i != f->tail; i++)
+			e[i & (cap - 1)] = f->e[i & (f->cap - 1)];
+		free(f->e);
+		f->e = e;
+		f->cap = cap;
+	}
+	f->e[f->tail++ & (f->cap - 1)] = (struct sim_fifo_ent){ pkt, tx_ns };
+}
+
+static bool sim_fifo_empty(const struct sim_fifo *f)
+{
+	return f->head == f->tail;
+}
+
+static struct sim_fifo_ent *sim_fifo_peek(struct sim_fifo *f)
+{
+	return &f->e[f->head & (f->cap - 1)];
+}
+
+static struct sock *sim_sk(struct sim_flow *f)
+{
+	return (struct sock *)&f->tp;
+}
+
+static struct sim_pkt *sim_pkt(struct sim_flow *f, u32 n)
+{
+	return &f->pkts[n & (f->cap - 1)];
+}
+
+/* Packet n is still outstanding, not yet cumulatively acked */
+static bool sim_pkt_valid(const struct sim_flow *f, u32 n)
+{
+	return !before(n, f->una) && before(n, f->nxt);
+}
+
+static void sim_grow(struct sim_flow *f)
+{
+	u32 cap = f->cap * 2, n;
+	struct sim_pkt *pkts = sim_zalloc(cap * sizeof(*pkts));
+
+	for (n = f->una; n != f->nxt; n++)
+		pkts[n & (cap - 1)] = *sim_pkt(f, n);
+	free(f->pkts);
+	f->pkts = pkts;
+	f->cap = cap;
+}
+
+static void sim_set_state(struct sim_flow *f, u8 state)
+{
+	struct sock *sk = sim_sk(f);
+
+	if (f->ops->set_state)
+		f->ops->set_state(sk, state);
+	inet_csk(sk)->icsk_ca_state = state;
+}
+
+static void sim_cwnd_event(struct sim_flow *f, enum tcp_ca_event event)
+{
+	if (f->ops->cwnd_event)
+		f->ops->cwnd_event(sim_sk(f), event);
+}
+
+static void sim_mark_lost(struct sim_flow *f, u32 n)
+{
+	struct sim_pkt *p = sim_pkt(f, n);
+
+	if (p->flags & PKT_RETRANS) {
+		p->flags &= ~PKT_RETRANS;
+		f->tp.retrans_out--;
+	} else {
+		p->flags |= PKT_LOST;
+		f->tp.lost_out++;
+	}
+	f->tp.lost++;
+	sim_fifo_push(&f->lostq, n, 0);
+}
+
+/*
+ * RACK without a reordering window, which is exact behind a FIFO: once a
+ * copy sent at tx_ns is acked, every copy sent before it that has not been
+ * acked was dropped.
+ */
+static u32 sim_rack(struct sim_flow *f, u64 tx_ns)
+{
+	u32 lost = 0;
+
+	if (before(f->rack_next, f->una))
+		f->rack_next = f->una;
+	while (f->rack_next != f->nxt && sim_pkt(f, f->rack_next)->first_tx_ns < tx_ns) {
+		struct sim_pkt *p = sim_pkt(f, f->rack_next);
+
+		if (sim_pkt_valid(f, f->rack_next) &&
+		    !(p->flags & (PKT_DELIVERED | PKT_LOST))) {
+			sim_mark_lost(f, f->rack_next);
+			lost++;
+		}
+		f->rack_next++;
+	}
+
+	while (!sim_fifo_empty(&f->rtxq) && sim_fifo_peek(&f->rtxq)->tx_ns < tx_ns) {
+		struct sim_fifo_ent e = *sim_fifo_peek(&f->rtxq);
+		struct sim_pkt *p = sim_pkt(f, e.pkt);
+
+		f->rtxq.head++;
+		if (sim_pkt_valid(f, e.pkt) && p->tx_ns == e.tx_ns &&
+		    (p->flags & (PKT_RETRANS | PKT_DELIVERED)) == PKT_RETRANS) {
+			sim_mark_lost(f, e.pkt);
+			lost++;
+		}
+	}
+	return lost;
+}
+
+static void sim_init_cwnd_reduction(struct sim_flow *f)
+{
+	struct tcp_sock *tp = &f->tp;
+
+	f->high = f->nxt;
+	tp->prior_cwnd = tp->snd_cwnd;
+	tp->prior_ssthresh = tp->snd_ssthresh;
+	f->prr_delivered = 0;
+	f->prr_out = 0;
+	tp->snd_ssthresh = f->ops->ssthresh(sim_sk(f));
+}
+
+static void sim_end_cwnd_reduction(struct sim_flow *f)
+{
+	struct tcp_sock *tp = &f->tp;
+
+	if (f->ops->cong_control)
+		return;
+
+	if (tp->snd_ssthresh < TCP_INFINITE_SSTHRESH)
+		tp->snd_cwnd = tp->snd_ssthresh;
+	sim_cwnd_event(f, CA_EVENT_COMPLETE_CWR);
+}
+
+/* Proportional rate reduction, as tcp_cwnd_reduction() */
+static void sim_prr(struct sim_flow *f, u32 newly_acked, u32 newly_lost,
+		    bool una_advanced)
+{
+	struct tcp_sock *tp = &f->tp;
+	int delta = tp->snd_ssthresh - tcp_packets_in_flight(tp);
+	int sndcnt;
+
+	if (!newly_acked || !tp->prior_cwnd)
+		return;
+
+	f->prr_delivered += newly_acked;
+	if (delta < 0) {
+		u64 dividend = (u64)tp->snd_ssthresh * f->prr_delivered + tp->prior_cwnd - 1;
+
+		sndcnt = dividend / tp->prior_cwnd - f->prr_out;
+	} else {
+		sndcnt = max((int)(f->prr_delivered - f->prr_out), (int)newly_acked);
+		if (una_advanced && !newly_lost)
+			sndcnt++;
+		sndcnt = min(delta, sndcnt);
+	}
+	sndcnt = max(sndcnt, f->prr_out ? 0 : 1);
+	tp->snd_cwnd = tcp_packets_in_flight(tp) + sndcnt;
+}
+
+/* The CA state machine, a much reduced tcp_fastretrans_alert() */
+static void sim_ca_state(struct sim_flow *f, bool ce)
+{
+	struct tcp_sock *tp = &f->tp;
+	u8 state = inet_csk(sim_sk(f))->icsk_ca_state;
+	bool done = !before(f->una, f->high);
+
+	switch (state) {
+	case TCP_CA_Open:
+	case TCP_CA_Disorder:
+		if (tp->lost_out) {
+			sim_init_cwnd_reduction(f);
+			sim_set_state(f, TCP_CA_Recovery);
+		} else if (ce && (tp->ecn_flags & TCP_ECN_OK)) {
+			sim_init_cwnd_reduction(f);
+			sim_set_state(f, TCP_CA_CWR);
+		}
+		break;
+
+	case TCP_CA_CWR:
+		if (tp->lost_out) {
+			/* already reducing, tcp_enter_recovery keeps ssthresh */
+			f->high = f->nxt;
+			sim_set_state(f, TCP_CA_Recovery);
+		} else if (done) {
+			sim_end_cwnd_reduction(f);
+			sim_set_state(f, TCP_CA_Open);
+		}
+		break;
+
+	case TCP_CA_Recovery:
+		if (done) {
+			sim_end_cwnd_reduction(f);
+			sim_set_state(f, TCP_CA_Open);
+		}
+		break;
+
+	case TCP_CA_Loss:
+		if (done)
+			sim_set_state(f, TCP_CA_Open);
+		break;
+	}
+}
+
+static void sim_arm_rto(struct sim_flow *f)
+{
+	u64 rto = f->srtt_ns ? f->srtt_ns + 4 * f->rttvar_ns : NSEC_PER_SEC;
+
+	rto = max(rto, SIM_RTO_MIN_NS) << f->rto_backoff;
+	f->rto_deadline = sim.now + min(rto, SIM_RTO_MAX_NS);
+	if (!f->rto_armed) {
+		f->rto_armed = true;
+		sim_schedule((struct sim_event){ .t = f->rto_deadline, .type = EV_RTO,
+						 .flow = f - sim.flows });
+	}
+}
+
+static void sim_link_start(void)
+{
+	sim.busy = true;
+	sim_schedule((struct sim_event){ .t = sim.now + sim.service_ns, .type = EV_DEPART });
+}
+
+static void sim_enqueue(struct sim_flow *f, u32 n, u64 tx_ns)
+{
+	u32 qmax = sim.buffer;
+
+	if (sim.now >= sim.warmup_ns)
+		sim.sent++;
+
+	if ((sim.loss > 0 && sim_random() < sim.loss) || sim.qlen >= qmax) {
+		if (sim.now >= sim.warmup_ns)
+			sim.dropped++;
+		return;
+	}
+
+	sim.q[(sim.qhead + sim.qlen++) % sim.qcap] = (struct sim_qent){
+		.enq_ns = sim.now,
+		.tx_ns = tx_ns,
+		.pkt = n,
+		.flow = f - sim.flows,
+		.ce = sim.ecn_k && sim.qlen > sim.ecn_k,
+	};
+	if (!sim.busy)
+		sim_link_start();
+}
+
+static bool sim_next_lost(struct sim_flow *f, u32 *n)
+{
+	while (!sim_fifo_empty(&f->lostq)) {
+		*n = sim_fifo_peek(&f->lostq)->pkt;
+		f->lostq.head++;
+		if (sim_pkt_valid(f, *n) && sim_pkt(f, *n)->flags == PKT_LOST)
+			return true;
+	}
+	return false;
+}
+
+static bool sim_paced(const struct sim_flow *f)
+{
+	const struct sock *sk = &f->tp.icsk.icsk_inet.sk;
+
+	return sk->sk_pacing_status != SK_PACING_NONE &&
+	       sk->sk_pacing_rate && sk->sk_pacing_rate != ~0UL;
+}
+
+static void sim_try_send(struct sim_flow *f)
+{
+	struct tcp_sock *tp = &f->tp;
+	struct sock *sk = sim_sk(f);
+
+	while (tcp_packets_in_flight(tp) < tp->snd_cwnd) {
+		struct sim_pkt *p;
+		u32 n;
+
+		/* the transfer is all sent */
+		if (sim.size && f->nxt == f->end && sim_fifo_empty(&f->lostq))
+			break;
+
+		if (sim_paced(f) && sim.now < f->next_tx_ns) {
+			if (!f->tx_timer) {
+				f->tx_timer = true;
+				sim_schedule((struct sim_event){ .t = f->next_tx_ns,
+								 .type = EV_SEND,
+								 .flow = f - sim.flows });
+			}
+			return;
+		}
+
+		if (!tcp_packets_in_flight(tp))
+			sim_cwnd_event(f, CA_EVENT_TX_START);
+
+		if (sim_next_lost(f, &n)) {
+			p = sim_pkt(f, n);
+			p->flags |= PKT_RETRANS;
+			tp->retrans_out++;
+			tp->total_retrans++;
+			sim_fifo_push(&f->rtxq, n, sim.now);
+		} else {
+			if (sim.size && f->nxt == f->end)
+				break;
+			if (f->nxt - f->una == f->cap)
+				sim_grow(f);
+			n = f->nxt++;
+			p = sim_pkt(f, n);
+			memset(p, 0, sizeof(*p));
+			p->first_tx_ns = sim.now;
+			tp->packets_out++;
+			tp->snd_nxt = f->nxt * sim.mss;
+		}
+		p->tx_ns = sim.now;
+		p->prior_delivered = tp->delivered;
+		p->prior_delivered_ns = f->delivered_ns;
+
+		if (tcp_in_cwnd_reduction(sk))
+			f->prr_out++;
+		tp->lsndtime = tcp_jiffies32;
+		if (sim_paced(f))
+			f->next_tx_ns = max(f->next_tx_ns, sim.now) +
+					(u64)sim.mss * NSEC_PER_SEC / sk->sk_pacing_rate;
+
+		sim_enqueue(f, n, sim.now);
+		if (!f->rto_armed)
+			sim_arm_rto(f);
+	}
+	tp->is_cwnd_limited = tcp_packets_in_flight(tp) >= tp->snd_cwnd;
+	tp->max_packets_out = tp->packets_out;
+}
+
+static void sim_rtt_update(struct sim_flow *f, u64 rtt_ns)
+{
+	if (!f->srtt_ns) {
+		f->srtt_ns = rtt_ns;
+		f->rttvar_ns = rtt_ns / 2;
+	} else {
+		u64 err = rtt_ns > f->srtt_ns ? rtt_ns - f->srtt_ns : f->srtt_ns - rtt_ns;
+
+		f->rttvar_ns = (3 * f->rttvar_ns + err) / 4;
+		f->srtt_ns = (7 * f->srtt_ns + rtt_ns) / 8;
+	}
+	f->tp.srtt_us = (f->srtt_ns / NSEC_PER_USEC) << 3;
+}
+
+static void sim_finish(struct sim_flow *f);
+
+static void sim_ack(struct sim_flow *f, u32 n, u64 tx_ns, bool ce)
+{
+	struct tcp_sock *tp = &f->tp;
+	struct sock *sk = sim_sk(f);
+	struct sim_pkt *p = sim_pkt(f, n);
+	u32 prior_in_flight = tcp_packets_in_flight(tp);
+	u32 prior_una = f->una, newly_lost, prior_delivered;
+	u64 prior_delivered_ns;
+	s32 rtt_us;
+	bool una_advanced;
+
+	/* the other copy was acked first */
+	if (!sim_pkt_valid(f, n) || (p->flags & PKT_DELIVERED))
+		return;
+
+	if (f->ops->in_ack_event)
+		f->ops->in_ack_event(sk, ce ? CA_ACK_ECE : 0);
+
+	if ((p->flags & PKT_LOST))
+		tp->lost_out--;
+	if ((p->flags & PKT_RETRANS))
+		tp->retrans_out--;
+	p->flags = PKT_DELIVERED;
+	tp->packets_out--;
+	tp->delivered++;
+	if (ce)
+		tp->delivered_ce++;
+	prior_delivered = p->prior_delivered;
+	prior_delivered_ns = p->prior_delivered_ns;
+	f->delivered_ns = sim.now;
+
+	/* timestamps tell us which copy this is, so retransmits are sampled too */
+	rtt_us = max((sim.now - tx_ns) / NSEC_PER_USEC, 1ULL);
+	if (sim.jitter_p > 0 && sim_random() < sim.jitter_p)
+		rtt_us += sim_random() * sim.jitter_us;
+	sim_rtt_update(f, sim.now - tx_ns);
+
+	while (f->una != f->nxt && (sim_pkt(f, f->una)->flags & PKT_DELIVERED))
+		f->una++;
+	tp->snd_una = f->una * sim.mss;
+	una_advanced = f->una != prior_una;
+
+	if (sim.now >= sim.warmup_ns)
+		f->bytes += sim.mss;
+	f->interval_bytes += sim.mss;
+
+	if (f->ops->pkts_acked) {
+		struct ack_sample sample = {
+			.pkts_acked = 1,
+			.rtt_us = rtt_us,
+			.in_flight = prior_in_flight,
+		};
+
+		f->ops->pkts_acked(sk, &sample);
+	}
+
+	newly_lost = sim_rack(f, tx_ns);
+	sim_ca_state(f, ce);
+
+	if (sim.record && f == &sim.flows[0]) {
+		struct ack_rec rec = {
+			.t_us = sim.now / NSEC_PER_USEC,
+			.acked = 1,
+			.rtt_us = rtt_us,
+			.ce = ce,
+			.lost = newly_lost,
+			.in_flight = prior_in_flight,
+			.delivered = tp->delivered - prior_delivered,
+			.interval_us = max((s64)((sim.now - prior_delivered_ns) / NSEC_PER_USEC), 1LL),
+		};
+
+		ack_trace_write(sim.record, &rec);
+	}
+
+	if (f->ops->cong_control) {
+		struct rate_sample rs = {
+			.prior_delivered = prior_delivered,
+			.delivered = tp->delivered - prior_delivered,
+			.interval_us = max((s64)((sim.now - prior_delivered_ns) / NSEC_PER_USEC), 1LL),
+			.rtt_us = rtt_us,
+			.losses = newly_lost,
+			.acked_sacked = 1,
+			.prior_in_flight = prior_in_flight,
+		};
+
+		f->ops->cong_control(sk, &rs);
+	} else if (tcp_in_cwnd_reduction(sk)) {
+		sim_prr(f, 1, newly_lost, una_advanced);
+	} else {
+		f->ops->cong_avoid(sk, tp->snd_una, 1);
+	}
+
+	if (una_advanced) {
+		f->rto_backoff = 0;
+		sim_arm_rto(f);
+	}
+	sim_try_send(f);
+
+	if (sim.size && f->una == f->end)
+		sim_finish(f);
+}
+
+/* tcp_enter_loss(): everything outstanding is marked lost, cwnd drops to 1 */
+static void sim_rto(struct sim_flow *f)
+{
+	struct tcp_sock *tp = &f->tp;
+	u8 state = inet_csk(sim_sk(f))->icsk_ca_state;
+	u32 n;
+
+	f->rto_armed = false;
+	if (!tp->packets_out)
+		return;
+	if (sim.now < f->rto_deadline) {
+		f->rto_armed = true;
+		sim_schedule((struct sim_event){ .t = f->rto_deadline, .type = EV_RTO,
+						 .flow = f - sim.flows });
+		return;
+	}
+
+	f->rtos++;
+	if (sim.record && f == &sim.flows[0]) {
+		struct ack_rec rec = {
+			.t_us = sim.now / NSEC_PER_USEC,
+			.rtt_us = -1,
+			.lost = tp->packets_out - tp->sacked_out - tp->lost_out,
+			.in_flight = tcp_packets_in_flight(tp),
+			.event = ACK_TRACE_RTO,
+		};
+
+		ack_trace_write(sim.record, &rec);
+	}
+	f->lostq.head = f->lostq.tail;
+	f->rtxq.head = f->rtxq.tail;
+	for (n = f->una; n != f->nxt; n++) {
+		struct sim_pkt *p = sim_pkt(f, n);
+
+		if (p->flags & PKT_DELIVERED)
+			continue;
+		if (p->flags & PKT_RETRANS)
+			tp->retrans_out--;
+		if (!(p->flags & PKT_LOST)) {
+			tp->lost_out++;
+			tp->lost++;
+		}
+		p->flags = PKT_LOST;
+		sim_fifo_push(&f->lostq, n, 0);
+	}
+	f->rack_next = f->nxt;
+
+	/* rto_backoff counts timeouts since progress, as icsk_retransmits */
+	if (state <= TCP_CA_Disorder || !before(f->una, f->high) ||
+	    (state == TCP_CA_Loss && !f->rto_backoff)) {
+		tp->prior_ssthresh = tp->snd_ssthresh;
+		tp->prior_cwnd = tp->snd_cwnd;
+		tp->snd_ssthresh = f->ops->ssthresh(sim_sk(f));
+		sim_cwnd_event(f, CA_EVENT_LOSS);
+	}
+	tp->snd_cwnd = tcp_packets_in_flight(tp) + 1;
+	tp->snd_cwnd_cnt = 0;
+	sim_set_state(f, TCP_CA_Loss);
+	f->high = f->nxt;
+
+	f->rto_backoff = min(f->rto_backoff + 1, 10U);
+	sim_arm_rto(f);
+	sim_try_send(f);
+}
+
+/*
+ * Start the flow, or with -z its next transfer.  A new transfer is a new
+ * connection to the congestion control, but packet numbers carry on so
+ * late copies of the previous transfer's packets stay recognisable.
+ */
+static void sim_start(struct sim_flow *f)
+{
+	struct sock *sk = sim_sk(f);
+	struct tcp_sock *tp = &f->tp;
+
+	if (!f->started) {
+		f->started = true;
+		f->cap = 1024;
+		f->pkts = sim_zalloc(f->cap * sizeof(*f->pkts));
+
+		sk->net = &init_net;
+		sk->sk_max_pacing_rate = ~0UL;
+		sk->sk_pacing_shift = 10;
+		inet_csk(sk)->icsk_ca_ops = f->ops;
+		inet_sk(sk)->inet_sport = 10000 + (f - sim.flows);
+		inet_sk(sk)->inet_dport = 5001;
+		tp->snd_cwnd_clamp = ~0U;
+		tp->mss_cache = sim.mss;
+		sim.last_start_ns = max(sim.last_start_ns, sim.now);
+	}
+	f->start_ns = sim.now;
+	f->end = f->nxt + sim.size;
+	f->high = f->nxt;
+	f->srtt_ns = f->rttvar_ns = 0;
+	f->rto_backoff = 0;
+	f->prr_delivered = f->prr_out = 0;
+
+	memset(inet_csk(sk)->icsk_ca_priv, 0, sizeof(inet_csk(sk)->icsk_ca_priv));
+	inet_csk(sk)->icsk_ca_state = TCP_CA_Open;
+	sk->sk_pacing_rate = 0;
+	sk->sk_pacing_status = SK_PACING_NONE;
+	tp->snd_cwnd = 10;
+	tp->snd_ssthresh = TCP_INFINITE_SSTHRESH;
+	tp->snd_cwnd_cnt = 0;
+	tp->prior_cwnd = tp->prior_ssthresh = 0;
+	tp->srtt_us = 0;
+	tp->is_cwnd_limited = false;
+	tp->max_packets_out = 0;
+	tp->ecn_flags = ecn ? TCP_ECN_OK : 0;
+
+	f->ops->init(sk);
+	sim_try_send(f);
+}
+
+/* -z: the transfer is acked, close the connection and start the next one */
+static void sim_finish(struct sim_flow *f)
+{
+	if (f->start_ns >= sim.warmup_ns) {
+		if (sim.nfct == sim.fct_cap) {
+			sim.fct_cap = sim.fct_cap ? 2 * sim.fct_cap : 1024;
+			sim.fct = realloc(sim.fct, sim.fct_cap * sizeof(*sim.fct));
+			if (!sim.fct) {
+				fprintf(stderr, "relentless_sim: out of memory\n");
+				exit(1);
+			}
+		}
+		sim.fct[sim.nfct++] = (sim.now - f->start_ns) / 1e6;
+	}
+	if (f->ops->release)
+		f->ops->release(sim_sk(f));
+	sim_schedule((struct sim_event){ .t = sim.now + sim.gap_ms * NSEC_PER_MSEC,
+					 .type = EV_START, .flow = f - sim.flows });
+}
+
+static void sim_depart(void)
+{
+	struct sim_qent e = sim.q[sim.qhead];
+	u64 qdelay = sim.now - sim.service_ns - e.enq_ns;
+
+	sim.qhead = (sim.qhead + 1) % sim.qcap;
+	sim.qlen--;
+
+	if (sim.now >= sim.warmup_ns) {
+		sim.busy_ns += sim.service_ns;
+		sim.hist[min(qdelay / SIM_HIST_BIN_NS, (u64)SIM_HIST_BINS - 1)]++;
+		sim.hist_n++;
+		sim.qdelay_sum += qdelay;
+	}
+
+	sim_schedule((struct sim_event){ .t = sim.now + sim.rtt_ns, .type = EV_ACK,
+					 .flow = e.flow, .pkt = e.pkt, .tx_ns = e.tx_ns,
+					 .ce = e.ce });
+	if (sim.qlen)
+		sim_link_start();
+	else
+		sim.busy = false;
+}
+
+static const char *const sim_state_names[] = { "open", "disorder", "cwr", "recovery", "loss" };
+
+static void sim_sample(void)
+{
+	u64 interval_ns = sim.interval_ms * NSEC_PER_MSEC;
+	double sum = 0, sumsq = 0;
+	u32 i, n = 0;
+
+	for (i = 0; i < sim.nflows; i++) {
+		struct sim_flow *f = &sim.flows[i];
+		double mbps = f->interval_bytes * 8.0 / interval_ns * 1e3;
+
+		if (!f->started)
+			continue;
+		if (sim.timeline) {
+			const struct relentless *ca = inet_csk_ca(sim_sk(f));
+
+			printf("t_ms=%.1f flow=%u cwnd=%u ssthresh=%u rtt_cwnd=%.2f"
+			       " rtt_min_us=%u rtt_thresh_us=%u mbps=%.2f qlen=%u state=%s\n",
+			       sim.now / 1e6, i, f->tp.snd_cwnd,
+			       min(f->tp.snd_ssthresh, (u32)TCP_INFINITE_SSTHRESH),
+			       ca->rtt_cwnd / (double)RELENTLESS_CWND_ONE,
+			       minmax_get(&ca->rtt_min), ca->rtt_thresh, mbps, sim.qlen,
+			       sim_state_names[inet_csk(sim_sk(f))->icsk_ca_state]);
+		}
+		sum += mbps;
+		sumsq += mbps * mbps;
+		n++;
+		f->interval_bytes = 0;
+	}
+
+	/* Jain's index over the flows running, once they all are */
+	sim.jain_last = sumsq > 0 ? sum * sum / (n * sumsq) : 0;
+	if (n == sim.nflows && sim.now > sim.last_start_ns + interval_ns &&
+	    sim.converge_ns < 0) {
+		if (sim.jain_last >= sim.jain_target) {
+			if (!sim.jain_ok) {
+				sim.jain_ok = true;
+				sim.jain_since = sim.now - interval_ns;
+			}
+			if (sim.now - sim.jain_since >= sim.hold_ms * NSEC_PER_MSEC)
+				sim.converge_ns = sim.jain_since - sim.last_start_ns;
+		} else {
+			sim.jain_ok = false;
+		}
+	}
+
+	sim_schedule((struct sim_event){ .t = sim.now + interval_ns, .type = EV_SAMPLE });
+}
+
+static double sim_hist_quantile(double q)
+{
+	u64 want = ceil(q * sim.hist_n), seen = 0;
+	u32 i;
+
+	for (i = 0; i < SIM_HIST_BINS; i++) {
+		seen += sim.hist[i];
+		if (seen >= want && seen)
+			return (i + 0.5) * SIM_HIST_BIN_NS / 1e6;
+	}
+	return 0;
+}
+
+static int sim_cmp_double(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static double sim_fct_quantile(double q)
+{
+	u64 i = ceil(q * sim.nfct);
+
+	return sim.nfct ? sim.fct[i ? i - 1 : 0] : 0;
+}
+
+static void sim_report(void)
+{
+	double span_ns = sim.duration_s * NSEC_PER_SEC - sim.warmup_ns;
+	double total = 0, sum = 0, sumsq = 0;
+	u64 retrans = 0;
+	u32 i, rtos = 0;
+
+	for (i = 0; i < sim.nflows; i++) {
+		double mbps = sim.flows[i].bytes * 8.0 / span_ns * 1e3;
+
+		total += mbps;
+		sum += mbps;
+		sumsq += mbps * mbps;
+		retrans += sim.flows[i].tp.total_retrans;
+		rtos += sim.flows[i].rtos;
+	}
+
+	printf("ops=%s flows=%u rate_mbps=%g rtt_ms=%g bdp_pkts=%.0f buffer=%u loss=%g"
+	       " ecn_k=%u util=%.4f goodput_mbps=%.2f qdelay_mean_ms=%.3f"
+	       " qdelay_p50_ms=%.3f qdelay_p99_ms=%.3f drop_rate=%.6f retrans=%llu"
+	       " rtos=%u jain=%.4f converge_ms=%.0f\n",
+	       sim.ops_name, sim.nflows, sim.rate_mbps, sim.rtt_ms,
+	       (double)sim.rtt_ns / sim.service_ns, sim.buffer, sim.loss, sim.ecn_k,
+	       sim.busy_ns / span_ns, total,
+	       sim.hist_n ? sim.qdelay_sum / sim.hist_n / 1e6 : 0,
+	       sim_hist_quantile(0.5), sim_hist_quantile(0.99),
+	       sim.sent ? (double)sim.dropped / sim.sent : 0,
+	       (unsigned long long)retrans, rtos,
+	       sumsq > 0 ? sum * sum / (sim.nflows * sumsq) : 0,
+	       sim.nflows > 1 && sim.converge_ns >= 0 ? sim.converge_ns / 1e6 : -1.0);
+
+	if (sim.size) {
+		double fct_sum = 0;
+		u64 j;
+
+		qsort(sim.fct, sim.nfct, sizeof(*sim.fct), sim_cmp_double);
+		for (j = 0; j < sim.nfct; j++)
+			fct_sum += sim.fct[j];
+		printf("transfers=%llu size_pkts=%u fct_mean_ms=%.3f fct_p50_ms=%.3f"
+		       " fct_p99_ms=%.3f\n", (unsigned long long)sim.nfct, sim.size,
+		       sim.nfct ? fct_sum / sim.nfct : 0, sim_fct_quantile(0.5),
+		       sim_fct_quantile(0.99));
+	}
+}
+
+static void sim_usage(void)
+{
+	fprintf(stderr,
+		"usage: relentless_sim [options]\n"
+		"  -c, --cc NAME          relentless or relentless_rate (relentless)\n"
+		"  -r, --rate MBPS        bottleneck rate (100)\n"
+		"  -t, --rtt MS           base RTT (20)\n"
+		"  -b, --buffer PKTS      drop tail buffer, 0 for one BDP (0)\n"
+		"  -l, --loss P           random loss probability (0)\n"
+		"  -J, --jitter P:US      add up to US usecs to a fraction P of the RTT\n"
+		"                         samples, as delayed ACKs or coalescing do (0:0)\n"
+		"  -k, --ecn-k PKTS       mark CE above this queue length, sets ecn=1 (0, off)\n"
+		"  -n, --flows N          competing flows (1)\n"
+		"  -s, --stagger MS       start flow i at i * MS (0)\n"
+		"  -d, --duration S       simulated time (30)\n"
+		"  -w, --warmup S         excluded from the results (2)\n"
+		"  -i, --interval MS      sampling interval (100)\n"
+		"  -j, --jain X           converged when Jain's index stays >= X (0.9)\n"
+		"  -H, --hold MS          ... for this long (1000)\n"
+		"  -m, --mss BYTES        (1448)\n"
+		"  -S, --seed N           (1)\n"
+		"  -z, --size PKTS        finite transfers of PKTS packets, repeated, reports\n"
+		"                         completion times (0, bulk)\n"
+		"  -g, --gap MS           idle time between a flow's transfers (100)\n"
+		"  -T, --timeline         print per flow state every interval\n"
+		"  -C, --counters         print the /proc/net/relentless counters\n"
+		"  -R, --record FILE      write flow 0's ACKs to FILE, see ack_trace.h\n"
+		"  -p, --param NAME=VAL   set a module parameter:\n");
+	sim_params_usage(stderr);
+}
+
+int main(int argc, char **argv)
+{
+	static const struct option opts[] = {
+		{ "cc", required_argument, NULL, 'c' },
+		{ "rate", required_argument, NULL, 'r' },
+		{ "rtt", required_argument, NULL, 't' },
+		{ "buffer", required_argument, NULL, 'b' },
+		{ "loss", required_argument, NULL, 'l' },
+		{ "jitter", required_argument, NULL, 'J' },
+		{ "ecn-k", required_argument, NULL, 'k' },
+		{ "flows", required_argument, NULL, 'n' },
+		{ "stagger", required_argument, NULL, 's' },
+		{ "duration", required_argument, NULL, 'd' },
+		{ "warmup", required_argument, NULL, 'w' },
+		{ "interval", required_argument, NULL, 'i' },
+		{ "jain", required_argument, NULL, 'j' },
+		{ "hold", required_argument, NULL, 'H' },
+		{ "mss", required_argument, NULL, 'm' },
+		{ "seed", required_argument, NULL, 'S' },
+		{ "size", required_argument, NULL, 'z' },
+		{ "gap", required_argument, NULL, 'g' },
+		{ "timeline", no_argument, NULL, 'T' },
+		{ "counters", no_argument, NULL, 'C' },
+		{ "record", required_argument, NULL, 'R' },
+		{ "param", required_argument, NULL, 'p' },
+		{ "help", no_argument, NULL, 'h' },
+		{ }
+	};
+	const struct tcp_congestion_ops *ops;
+	u64 end_ns;
+	u32 i;
+	int c;
+
+	while ((c = getopt_long(argc, argv, "c:r:t:b:l:J:k:n:s:d:w:i:j:H:m:S:z:g:TCR:p:h",
+				opts, NULL)) != -1) {
+		switch (c) {
+		case 'c': sim.ops_name = optarg; break;
+		case 'r': sim.rate_mbps = atof(optarg); break;
+		case 't': sim.rtt_ms = atof(optarg); break;
+		case 'b': sim.buffer = strtoul(optarg, NULL, 0); break;
+		case 'l': sim.loss = atof(optarg); break;
+		case 'J':
+			if (sscanf(optarg, "%lf:%lf", &sim.jitter_p, &sim.jitter_us) != 2) {
+				sim_usage();
+				return 1;
+			}
+			break;
+		case 'k': sim.ecn_k = strtoul(optarg, NULL, 0); ecn = true; break;
+		case 'n': sim.nflows = strtoul(optarg, NULL, 0); break;
+		case 's': sim.stagger_ms = atof(optarg); break;
+		case 'd': sim.duration_s = atof(optarg); break;
+		case 'w': sim.warmup_s = atof(optarg); break;
+		case 'i': sim.interval_ms = atof(optarg); break;
+		case 'j': sim.jain_target = atof(optarg); break;
+		case 'H': sim.hold_ms = atof(optarg); break;
+		case 'm': sim.mss = strtoul(optarg, NULL, 0); break;
+		case 'S': sim.seed = strtoull(optarg, NULL, 0) ?: 1; break;
+		case 'z': sim.size = strtoul(optarg, NULL, 0); break;
+		case 'g': sim.gap_ms = atof(optarg); break;
+		case 'T': sim.timeline = true; break;
+		case 'C': sim.counters = true; break;
+		case 'R':
+			sim.record = fopen(optarg, "w");
+			if (!sim.record) {
+				perror(optarg);
+				return 1;
+			}
+			fputs(ACK_TRACE_HEADER, sim.record);
+			break;
+		case 'p':
+			if (sim_set_param(optarg)) {
+				fprintf(stderr, "relentless_sim: unknown parameter %s\n", optarg);
+				return 1;
+			}
+			break;
+		default:
+			sim_usage();
+			return c == 'h' ? 0 : 1;
+		}
+	}
+
+	if (optind != argc || sim.nflows < 1 || sim.nflows > SIM_MAX_FLOWS ||
+	    sim.rate_mbps <= 0 || sim.rtt_ms <= 0 || !sim.mss || sim.interval_ms <= 0 ||
+	    sim.warmup_s >= sim.duration_s) {
+		sim_usage();
+		return 1;
+	}
+
+	if (relentless_register()) {
+		fprintf(stderr, "relentless_sim: module init failed\n");
+		return 1;
+	}
+	ops = sim_find_congestion_control(sim.ops_name);
+	if (!ops) {
+		fprintf(stderr, "relentless_sim: no congestion control %s\n", sim.ops_name);
+		return 1;
+	}
+
+	sim.service_ns = max(llround(sim.mss * 8.0 * 1e3 / sim.rate_mbps), 1LL);
+	sim.rtt_ns = sim.rtt_ms * NSEC_PER_MSEC;
+	if (!sim.buffer)
+		sim.buffer = max((u32)(sim.rtt_ns / sim.service_ns), 1U);
+	sim.qcap = sim.buffer + 1;
+	sim.q = sim_zalloc(sim.qcap * sizeof(*sim.q));
+	sim.hist = sim_zalloc(SIM_HIST_BINS * sizeof(*sim.hist));
+	sim.warmup_ns = sim.warmup_s * NSEC_PER_SEC;
+	end_ns = sim.duration_s * NSEC_PER_SEC;
+
+	for (i = 0; i < sim.nflows; i++) {
+		sim.flows[i].ops = ops;
+		sim_schedule((struct sim_event){ .t = i * sim.stagger_ms * NSEC_PER_MSEC,
+						 .type = EV_START, .flow = i });
+	}
+	sim_schedule((struct sim_event){ .t = sim.interval_ms * NSEC_PER_MSEC,
+					 .type = EV_SAMPLE });
+
+	while (sim.nevents && sim.heap[0].t <= end_ns) {
+		struct sim_event ev = sim_next_event();
+		struct sim_flow *f = &sim.flows[ev.flow];
+
+		sim.now = ev.t;
+		tcp_jiffies32 = sim.now / NSEC_PER_MSEC;
+		f->tp.tcp_mstamp = sim.now / NSEC_PER_USEC;
+
+		switch (ev.type) {
+		case EV_START:
+			sim_start(f);
+			break;
+		case EV_DEPART:
+			sim_depart();
+			break;
+		case EV_ACK:
+			sim_ack(f, ev.pkt, ev.tx_ns, ev.ce);
+			break;
+		case EV_SEND:
+			f->tx_timer = false;
+			sim_try_send(f);
+			break;
+		case EV_RTO:
+			sim_rto(f);
+			break;
+		case EV_SAMPLE:
+			sim_sample();
+			break;
+		}
+	}
+
+	sim_report();
+	if (sim.record)
+		fclose(sim.record);
+	for (i = 0; i < sim.nflows; i++)
+		if (sim.flows[i].started && ops->release &&
+		    !(sim.size && sim.flows[i].una == sim.flows[i].end))
+			ops->release(&sim.flows[i].tp.icsk.icsk_inet.sk);
+	if (sim.counters)
+		sim_proc_show(stdout);
+	relentless_unregister();
+	return 0;
+}
@@ -0,0 +1,246 @@
+/*
+ * Kernel functions used by tcp_relentless.c, for the simulator.  The
+ * window and min filter helpers are copies of net/ipv4/tcp_cong.c and
+ * lib/win_minmax.c so the module sees the same arithmetic as in the kernel.
+ */
+
+#include "sim_kernel.h"
+
+struct module __this_module;
+struct net init_net = { .ipv4.sysctl_tcp_min_tso_segs = 2 };
+u32 tcp_jiffies32;
+
+#define SIM_MAX_CA	4
+
+static struct tcp_congestion_ops *sim_ca[SIM_MAX_CA];
+
+static u32 minmax_subwin_update(struct minmax *m, u32 win,
+				const struct minmax_sample *val)
+{
+	u32 dt = val->t - m->s[0].t;
+
+	if (dt > win) {
+		/*
+		 * Passed entire window without a new val so make 2nd
+		 * choice the new val & 3rd choice the new 2nd choice.
+		 * we may have to iterate this since our 2nd choice
+		 * may also be outside the window (we checked on entry
+		 * that the third choice was in the window).
+		 */
+		m->s[0] = m->s[1];
+		m->s[1] = m->s[2];
+		m->s[2] = *val;
+		if (val->t - m->s[0].t > win) {
+			m->s[0] = m->s[1];
+			m->s[1] = m->s[2];
+			m->s[2] = *val;
+		}
+	} else if (m->s[1].t == m->s[0].t && dt > win / 4) {
+		/*
+		 * We've passed a quarter of the window without a new val
+		 * so take a 2nd choice from the 2nd quarter of the window.
+		 */
+		m->s[2] = m->s[1] = *val;
+	} else if (m->s[2].t == m->s[1].t && dt > win / 2) {
+		/*
+		 * We've passed half the window without finding a new val
+		 * so take a 3rd choice from the last half of the window
+		 */
+		m->s[2] = *val;
+	}
+	return m->s[0].v;
+}
+
+u32 minmax_running_min(struct minmax *m, u32 win, u32 t, u32 meas)
+{
+	struct minmax_sample val = { .t = t, .v = meas };
+
+	if (val.v <= m->s[0].v ||	  /* found new min? */
+	    val.t - m->s[2].t > win)	  /* nothing left in window? */
+		return minmax_reset(m, t, meas);  /* forget earlier samples */
+
+	if (val.v <= m->s[1].v)
+		m->s[2] = m->s[1] = val;
+	else if (val.v <= m->s[2].v)
+		m->s[2] = val;
+
+	return minmax_subwin_update(m, win, &val);
+}
+
+u32 tcp_slow_start(struct tcp_sock *tp, u32 acked)
+{
+	u32 cwnd = min(tp->snd_cwnd + acked, tp->snd_ssthresh);
+
+	acked -= cwnd - tp->snd_cwnd;
+	tp->snd_cwnd = min(cwnd, tp->snd_cwnd_clamp);
+
+	return acked;
+}
+
+void tcp_cong_avoid_ai(struct tcp_sock *tp, u32 w, u32 acked)
+{
+	/* If credits accumulated at a higher w, apply them gently now. */
+	if (tp->snd_cwnd_cnt >= w) {
+		tp->snd_cwnd_cnt = 0;
+		tp->snd_cwnd++;
+	}
+
+	tp->snd_cwnd_cnt += acked;
+	if (tp->snd_cwnd_cnt >= w) {
+		u32 delta = tp->snd_cwnd_cnt / w;
+
+		tp->snd_cwnd_cnt -= delta * w;
+		tp->snd_cwnd += delta;
+	}
+	tp->snd_cwnd = min(tp->snd_cwnd, tp->snd_cwnd_clamp);
+}
+
+/* Not the kernel's jhash, any decent mix will do for the model */
+u32 jhash2(const u32 *k, u32 length, u32 initval)
+{
+	u32 h = initval ^ 0x9e3779b9;
+
+	while (length--) {
+		h ^= *k++;
+		h *= 0x01000193;
+		h ^= h >> 15;
+	}
+	return h;
+}
+
+/* The model's receiver does not delay ACKs, so there is nothing to flush */
+void __tcp_send_ack(struct sock *sk, u32 rcv_nxt)
+{
+}
+
+int tcp_register_congestion_control(struct tcp_congestion_ops *ca)
+{
+	int i;
+
+	for (i = 0; i < SIM_MAX_CA; i++) {
+		if (!sim_ca[i]) {
+			sim_ca[i] = ca;
+			return 0;
+		}
+	}
+	return -ENOMEM;
+}
+
+void tcp_unregister_congestion_control(struct tcp_congestion_ops *ca)
+{
+	int i;
+
+	for (i = 0; i < SIM_MAX_CA; i++)
+		if (sim_ca[i] == ca)
+			sim_ca[i] = NULL;
+}
+
+struct tcp_congestion_ops *sim_find_congestion_control(const char *name)
+{
+	int i;
+
+	for (i = 0; i < SIM_MAX_CA; i++)
+		if (sim_ca[i] && !strcmp(sim_ca[i]->name, name))
+			return sim_ca[i];
+	return NULL;
+}
+
+int register_pernet_subsys(struct pernet_operations *ops)
+{
+	int ret;
+
+	init_net.gen = calloc(1, ops->size);
+	if (!init_net.gen)
+		return -ENOMEM;
+	*ops->id = 0;
+
+	ret = ops->init(&init_net);
+	if (ret) {
+		free(init_net.gen);
+		init_net.gen = NULL;
+	}
+	return ret;
+}
+
+void unregister_pernet_subsys(struct pernet_operations *ops)
+{
+	ops->exit(&init_net);
+	free(init_net.gen);
+	init_net.gen = NULL;
+}
+
+int proc_douintvec(void)
+{
+	return 0;
+}
+
+int proc_douintvec_minmax(void)
+{
+	return 0;
+}
+
+const struct kernel_param_ops param_ops_uint;
+const struct kernel_param_ops param_ops_bool;
+
+int param_get_uint(char *buffer, const struct kernel_param *kp)
+{
+	return sprintf(buffer, "%u\n", *(unsigned int *)kp->arg);
+}
+
+int kstrtouint(const char *s, unsigned int base, unsigned int *res)
+{
+	unsigned long v;
+	char *end;
+
+	errno = 0;
+	v = strtoul(s, &end, base);
+	if (end == s || (*end && strcmp(end, "\n")))
+		return -EINVAL;
+	if (errno || v > UINT_MAX)
+		return -ERANGE;
+	*res = v;
+	return 0;
+}
+
+struct ctl_table_header *register_net_sysctl_sz(struct net *net, const char *path,
+						struct ctl_table *table, size_t table_size)
+{
+	struct ctl_table_header *header = calloc(1, sizeof(*header));
+
+	if (header)
+		header->ctl_table_arg = table;
+	return header;
+}
+
+void unregister_net_sysctl_table(struct ctl_table_header *header)
+{
+	free(header);
+}
+
+struct proc_dir_entry {
+	int (*show)(struct seq_file *seq, void *v);
+};
+
+static struct proc_dir_entry sim_proc_entry;
+
+struct proc_dir_entry *proc_create_net_single(const char *name, int mode,
+					      struct proc_dir_entry *parent,
+					      int (*show)(struct seq_file *, void *),
+					      void *data)
+{
+	sim_proc_entry.show = show;
+	return &sim_proc_entry;
+}
+
+void remove_proc_entry(const char *name, struct proc_dir_entry *parent)
+{
+	sim_proc_entry.show = NULL;
+}
+
+void sim_proc_show(FILE *f)
+{
+	struct seq_file seq = { .f = f, .net = &init_net };
+
+	if (sim_proc_entry.show)
+		sim_proc_entry.show(&seq, NULL);
+}
@@ -0,0 +1,65 @@
+/*
+ * Module parameters the userspace tools can set with -p name=value.
+ * Included after tcp_relentless.c, whose parameter variables it names.
+ */
+#ifndef _SIM_PARAMS_H
+#define _SIM_PARAMS_H
+
+static const struct {
+	const char *name;
+	unsigned int *uint;
+	bool *flag;
+} sim_params[] = {
+	{ "markthresh", &relentless_defaults.markthresh },
+	{ "slowstart_rtt_observations_needed",
+	  &relentless_defaults.slowstart_rtt_observations_needed },
+	{ "rtt_min_win_sec", &relentless_defaults.rtt_min_win_sec },
+	{ "qdelay_floor_us", &relentless_defaults.qdelay_floor_us },
+	{ "qdelay_target_us", &relentless_defaults.qdelay_target_us },
+	{ "increase_law", &increase_law },
+	{ "hystart_detect", &hystart_detect },
+	{ "hystart_low_window", &hystart_low_window },
+	{ "hystart_ack_delta_us", &hystart_ack_delta_us },
+	{ "backoff_gain", &backoff_gain },
+	{ "backoff_mode", &backoff_mode },
+	{ "sample_gain", &sample_gain },
+	{ "rtt_filter_samples", &rtt_filter_samples },
+	{ "pacing_gain", &pacing_gain },
+	{ "pacing_ss_gain", &pacing_ss_gain },
+	{ "dst_cache_size", &dst_cache_size },
+	{ "dst_init_cwnd_max", &dst_init_cwnd_max },
+	{ "dst_save_timeout_sec", &dst_save_timeout_sec },
+	{ "round_updates", NULL, &round_updates },
+	{ "ecn", NULL, &ecn },
+	{ "dst_cache", NULL, &dst_cache },
+};
+
+static int sim_set_param(const char *arg)
+{
+	const char *eq = strchr(arg, '=');
+	size_t i;
+
+	if (!eq)
+		return -1;
+	for (i = 0; i < sizeof(sim_params) / sizeof(sim_params[0]); i++) {
+		if (strlen(sim_params[i].name) != (size_t)(eq - arg) ||
+		    strncmp(sim_params[i].name, arg, eq - arg))
+			continue;
+		if (sim_params[i].uint)
+			*sim_params[i].uint = strtoul(eq + 1, NULL, 0);
+		else
+			*sim_params[i].flag = strtoul(eq + 1, NULL, 0) != 0;
+		return 0;
+	}
+	return -1;
+}
+
+static void sim_params_usage(FILE *f)
+{
+	size_t i;
+
+	for (i = 0; i < sizeof(sim_params) / sizeof(sim_params[0]); i++)
+		fprintf(f, "                           %s\n", sim_params[i].name);
+}
+
+#endif /* _SIM_PARAMS_H */
@@ -0,0 +1,12 @@
+#!/bin/sh
+# Example sweep: markthresh against buffer size, four flows starting 2s
+# apart.  Extra arguments are passed on to every run, e.g.
+#	sim/sweep.sh -r 1000 -t 10 -p increase_law=2
+SIM=${SIM:-$(dirname "$0")/relentless_sim}
+
+for buffer in 0 64 16; do
+	for markthresh in 58 116 174 348 696; do
+		"$SIM" -n 4 -s 2000 -d 40 -b $buffer \
+			-p markthresh=$markthresh "$@" || exit 1
+	done
+done
@@ -0,0 +1,79 @@
+#!/bin/sh
+# Convert tcp:tcp_probe tracepoint output into an ack_trace.h ACK trace for
+# relentless_replay, for connections where no capture was taken.
+#
+#	echo 1 > /sys/kernel/tracing/events/tcp/tcp_probe/enable
+#	cat /sys/kernel/tracing/trace_pipe > probe.txt
+#	sim/tcp_probe2ack.sh [-p port] [-m mss] probe.txt > trace
+#
+# tcp_probe fires for each segment received, with snd_una, snd_nxt and
+# srtt but no per ACK RTT sample and no loss count, so the trace carries
+# the smoothed RTT and no losses; use pcap2ack when losses matter.  The
+# first connection seen is used, or the first one with the given port.
+PORT=
+MSS=1448
+
+while getopts p:m: opt; do
+	case $opt in
+	p) PORT=$OPTARG ;;
+	m) MSS=$OPTARG ;;
+	*) echo "usage: $0 [-p port] [-m mss] [file]" >&2; exit 1 ;;
+	esac
+done
+shift $((OPTIND - 1))
+
+awk -v port="$PORT" -v mss="$MSS" '
+function hex(s,	i, c, v) {
+	v = 0
+	s = tolower(s)
+	sub(/^0x/, "", s)
+	for (i = 1; i <= length(s); i++) {
+		c = index("0123456789abcdef", substr(s, i, 1))
+		if (!c)
+			break
+		v = v * 16 + c - 1
+	}
+	return v
+}
+function field(name,	i) {
+	for (i = 1; i <= NF; i++)
+		if (index($i, name "=") == 1)
+			return substr($i, length(name) + 2)
+	return ""
+}
+BEGIN { print "# t_us acked rtt_us ce lost in_flight delivered interval_us event" }
+/tcp_probe:/ {
+	src = field("src"); dst = field("dest")
+	if (flow == "") {
+		if (port != "" && src !~ (":" port "$") && dst !~ (":" port "$"))
+			next
+		flow = src " " dst
+	} else if (src " " dst != flow) {
+		next
+	}
+	for (i = 1; i <= NF; i++)
+		if ($i ~ /^[0-9]+\.[0-9]+:$/)
+			t = substr($i, 1, length($i) - 1) * 1000000
+	una = hex(field("snd_una")); nxt = hex(field("snd_nxt"))
+	srtt = field("srtt") + 0
+	if (have) {
+		d = una - prev_una
+		if (d < 0)
+			d += 4294967296
+		acked = int(d / mss)
+		if (acked > 0 && d < 2147483648) {
+			if (!t0)
+				t0 = prev_t
+			in_flight = prev_nxt - prev_una
+			if (in_flight < 0)
+				in_flight += 4294967296
+			in_flight = int(in_flight / mss)
+			printf "%d %d %d 0 0 %d %d %d 0\n", t - t0, acked,
+				srtt ? srtt : -1, in_flight, in_flight, srtt ? srtt : 1
+			prev_una = (prev_una + acked * mss) % 4294967296
+		}
+	} else {
+		prev_una = una
+	}
+	have = 1; prev_nxt = nxt; prev_t = t
+}' "$@"
@@ -0,0 +1,343 @@
+/*
+ * Relentless TCP as a BPF struct_ops congestion control.
+ *
+ * This registers "relentless_bpf" and runs the delay based controller of
+ * tcp_relentless.c, with the state and arithmetic from
+ * tcp_relentless_core.h, so the threshold law and gains can be changed
+ * on a live system without building or loading a module.  It covers the
+ * default configuration of the module: the sample threshold from rtt_min,
+ * markthresh and the qdelay bounds, the fixed per-ACK backoff, the
+ * selectable increase law and the loss rule.  HyStart, ECN, proportional
+ * backoff, per round updates, pacing, tracepoints and the sysctls are only
+ * in the module.
+ *
+ * Build with "make bpf" and register with
+ *	bpftool struct_ops register tcp_relentless.bpf.o
+ * then select it like any other congestion control.  The tunables below
+ * are in the program's .data map and can be rewritten while it runs, with
+ * bpftool map update or a skeleton.  markthresh,
+ * slowstart_rtt_observations_needed and the qdelay bounds are copied into
+ * each connection when it is initialised, as with the module parameters;
+ * the others are read on every ACK and apply to existing connections too.
+ */
+
+#include "vmlinux.h"
+#include <bpf/bpf_helpers.h>
+#include <bpf/bpf_tracing.h>
+#include <bpf/bpf_core_read.h>
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define U16_MAX ((u16)~0U)
+#define U32_MAX ((u32)~0U)
+#define USEC_PER_SEC 1000000U
+
+#include "tcp_relentless_core.h"
+
+char _license[] SEC("license") = "GPL";
+
+/* Same meaning and defaults as the module parameters of the same name */
+u32 markthresh = 174;
+u32 slowstart_rtt_observations_needed = 10;
+u32 rtt_min_win_sec = 10;
+u32 qdelay_floor_us = 0;
+u32 qdelay_target_us = 0;
+u32 increase_law = RELENTLESS_INCREASE_RENO;
+u32 backoff_gain = 64;
+u32 sample_gain = RELENTLESS_CWND_ONE;
+u32 rtt_filter_samples = 1;
+
+extern __u32 tcp_slow_start(struct tcp_sock *tp, __u32 acked) __ksym;
+extern void tcp_cong_avoid_ai(struct tcp_sock *tp, __u32 w, __u32 acked) __ksym;
+
+_Static_assert(sizeof(struct relentless) <=
+	       sizeof(((struct inet_connection_sock *)0)->icsk_ca_priv),
+	       "struct relentless does not fit in icsk_ca_priv");
+
+static struct tcp_sock *tcp_sk(const struct sock *sk)
+{
+	return (struct tcp_sock *)sk;
+}
+
+static struct inet_connection_sock *inet_csk(const struct sock *sk)
+{
+	return (struct inet_connection_sock *)sk;
+}
+
+static struct relentless *inet_csk_ca(const struct sock *sk)
+{
+	return (struct relentless *)inet_csk(sk)->icsk_ca_priv;
+}
+
+static u8 relentless_ca_state(const struct sock *sk)
+{
+	return BPF_CORE_READ_BITFIELD(inet_csk(sk), icsk_ca_state);
+}
+
+static bool before(u32 seq1, u32 seq2)
+{
+	return (s32)(seq1 - seq2) < 0;
+}
+
+static bool tcp_in_slow_start(const struct tcp_sock *tp)
+{
+	return tp->snd_cwnd < tp->snd_ssthresh;
+}
+
+static u32 tcp_packets_in_flight(const struct tcp_sock *tp)
+{
+	return tp->packets_out - (tp->sacked_out + tp->lost_out) + tp->retrans_out;
+}
+
+static bool tcp_is_cwnd_limited(const struct sock *sk)
+{
+	const struct tcp_sock *tp = tcp_sk(sk);
+
+	if (tcp_in_slow_start(tp))
+		return tp->snd_cwnd < 2 * tp->max_packets_out;
+	return BPF_CORE_READ_BITFIELD(tp, is_cwnd_limited);
+}
+
+/*
+ * lib/win_minmax.c cannot be called from BPF, so this is a copy of its
+ * running min, timed in usecs of tcp_mstamp instead of jiffies.
+ */
+static u32 relentless_minmax_reset(struct minmax *m, u32 t, u32 meas)
+{
+	struct minmax_sample val = { .t = t, .v = meas };
+
+	m->s[2] = m->s[1] = m->s[0] = val;
+	return m->s[0].v;
+}
+
+static u32 relentless_minmax_subwin_update(struct minmax *m, u32 win,
+					   const struct minmax_sample *val)
+{
+	u32 dt = val->t - m->s[0].t;
+
+	if (dt > win) {
+		m->s[0] = m->s[1];
+		m->s[1] = m->s[2];
+		m->s[2] = *val;
+		if (val->t - m->s[0].t > win) {
+			m->s[0] = m->s[1];
+			m->s[1] = m->s[2];
+			m->s[2] = *val;
+		}
+	} else if (m->s[1].t == m->s[0].t && dt > win / 4) {
+		m->s[2] = m->s[1] = *val;
+	} else if (m->s[2].t == m->s[1].t && dt > win / 2) {
+		m->s[2] = *val;
+	}
+	return m->s[0].v;
+}
+
+static u32 relentless_minmax_running_min(struct minmax *m, u32 win, u32 t, u32 meas)
+{
+	struct minmax_sample val = { .t = t, .v = meas };
+
+	if (val.v <= m->s[0].v || val.t - m->s[2].t > win)
+		return relentless_minmax_reset(m, t, meas);
+
+	if (val.v <= m->s[1].v)
+		m->s[2] = m->s[1] = val;
+	else if (val.v <= m->s[2].v)
+		m->s[2] = val;
+
+	return relentless_minmax_subwin_update(m, win, &val);
+}
+
+static void relentless_round_start(struct sock *sk)
+{
+	const struct tcp_sock *tp = tcp_sk(sk);
+
+	relentless_round_reset(inet_csk_ca(sk), tp->snd_nxt, (u32)tp->tcp_mstamp);
+}
+
+SEC("struct_ops")
+void BPF_PROG(relentless_bpf_init, struct sock *sk)
+{
+	const struct tcp_sock *tp = tcp_sk(sk);
+	struct relentless *ca = inet_csk_ca(sk);
+
+	ca->markthresh = min(markthresh, U16_MAX);
+	ca->rtt_observations_needed = min(slowstart_rtt_observations_needed, U16_MAX);
+	ca->qdelay_floor_us = min(qdelay_floor_us, U16_MAX);
+	ca->qdelay_target_us = min(qdelay_target_us, U16_MAX);
+
+	ca->save_cwnd = 0;
+	ca->cwndnlosses = 0;
+
+	ca->rtts_observed = 0;
+	ca->backoffs = 0;
+	ca->rtt_over = 0;
+	relentless_minmax_reset(&ca->rtt_min, (u32)tp->tcp_mstamp, USEC_PER_SEC);
+	ca->rtt_thresh = USEC_PER_SEC;
+	ca->rtt_cwnd = relentless_cwnd_to_fp(tp->snd_cwnd);
+
+	ca->bw = 0;
+	ca->prior_bw = 0;
+
+	relentless_round_start(sk);
+
+	ca->ce_state = 0;
+	ca->ece = 0;
+	ca->prior_rcv_nxt = 0;
+
+	ca->alpha = 0;
+}
+
+static void relentless_increase(struct sock *sk, u32 acked)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	u32 prior_cwnd = tp->snd_cwnd;
+
+	if (tcp_in_slow_start(tp)) {
+		acked = tcp_slow_start(tp, acked);
+		if (!acked)
+			goto done;
+	}
+
+	tcp_cong_avoid_ai(tp, relentless_ai_cnt(increase_law, tp->snd_cwnd, 1), acked);
+done:
+	relentless_rtt_cwnd_add(inet_csk_ca(sk),
+				((s64)tp->snd_cwnd - prior_cwnd) * RELENTLESS_CWND_ONE);
+}
+
+SEC("struct_ops")
+void BPF_PROG(relentless_bpf_cong_avoid, struct sock *sk, u32 ack, u32 acked)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+
+	/* defeat all policy based cwnd reductions */
+	tp->snd_cwnd = max(tp->snd_cwnd, tcp_packets_in_flight(tp));
+
+	if (increase_law != RELENTLESS_INCREASE_SAMPLE && tcp_is_cwnd_limited(sk))
+		relentless_increase(sk, acked);
+
+	relentless_open_snapshot(inet_csk_ca(sk), relentless_ca_state(sk), tp->snd_cwnd,
+				 tp->lost, tcp_is_cwnd_limited(sk));
+}
+
+SEC("struct_ops")
+u32 BPF_PROG(relentless_bpf_ssthresh, struct sock *sk)
+{
+	const struct tcp_sock *tp = tcp_sk(sk);
+
+	return relentless_cwnd_ssthresh(tp->snd_cwnd, tp->lost_out);
+}
+
+SEC("struct_ops")
+u32 BPF_PROG(relentless_bpf_undo_cwnd, struct sock *sk)
+{
+	return relentless_undo(inet_csk_ca(sk), tcp_sk(sk)->snd_cwnd);
+}
+
+SEC("struct_ops")
+void BPF_PROG(relentless_bpf_cwnd_event, struct sock *sk, enum tcp_ca_event event)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct relentless *ca = inet_csk_ca(sk);
+
+	switch (event) {
+	case CA_EVENT_TX_START:
+		relentless_round_start(sk);
+		break;
+
+	case CA_EVENT_COMPLETE_CWR:
+		/* the loss rule, as in relentless_event() */
+		tp->snd_cwnd = relentless_end_recovery(ca, tp->snd_cwnd, tp->lost,
+						       &tp->snd_ssthresh);
+		break;
+
+	case CA_EVENT_LOSS:
+		/* tcp_enter_loss() is reducing ssthresh, see relentless_event() */
+		tp->snd_ssthresh = relentless_loss_ssthresh(ca, relentless_ca_state(sk),
+							    tp->prior_cwnd, tp->lost - tp->lost_out,
+							    tcp_is_cwnd_limited(sk));
+		break;
+
+	default:
+		break;
+	}
+}
+
+SEC("struct_ops")
+void BPF_PROG(relentless_bpf_set_state, struct sock *sk, u8 new_state)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct relentless *ca = inet_csk_ca(sk);
+	u8 old_state = relentless_ca_state(sk);
+
+	if (relentless_enter_reduction(old_state, new_state) && new_state != TCP_CA_Loss)
+		relentless_snapshot(ca, tp->prior_cwnd, tp->lost - tp->lost_out,
+				    tcp_is_cwnd_limited(sk));
+
+	if (new_state == TCP_CA_Loss) {
+		relentless_restart(ca, tp->snd_cwnd);
+		relentless_round_start(sk);
+	} else if (new_state == TCP_CA_Open && old_state >= TCP_CA_CWR) {
+		relentless_adopt_cwnd(ca, tp->snd_cwnd);
+		relentless_round_start(sk);
+	}
+}
+
+SEC("struct_ops")
+void BPF_PROG(relentless_bpf_pkts_acked, struct sock *sk,
+	      const struct ack_sample *sample)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct relentless *ca = inet_csk_ca(sk);
+	u32 num_acked = sample->pkts_acked;
+	u32 r = 0, rtt_min = ca->rtt_min.s[0].v;
+	bool signal = false, congested = false;
+
+	if (!num_acked)
+		return;
+
+	if (sample->rtt_us > 0) {
+		/* usecs, the product in 64 bits so large windows do not wrap */
+		u32 win = min((u64)rtt_min_win_sec * USEC_PER_SEC, (u64)U32_MAX);
+		u32 prior_rtt_min = rtt_min;
+
+		r = (u32)sample->rtt_us;
+		relentless_rtt_sample(ca, r);
+		rtt_min = relentless_minmax_running_min(&ca->rtt_min, win,
+							(u32)tp->tcp_mstamp, r);
+		if (rtt_min != prior_rtt_min)
+			ca->rtt_thresh = relentless_rtt_thresh(ca, rtt_min);
+	}
+
+	if (relentless_delay_signal(ca, r)) {
+		signal = true;
+		congested = relentless_rtt_over(ca, r, rtt_filter_samples);
+	}
+
+	relentless_account(ca, num_acked, r, congested, false);
+
+	if (congested) {
+		relentless_fixed_backoff(ca, num_acked, backoff_gain);
+		tp->snd_cwnd = relentless_fp_to_cwnd(ca->rtt_cwnd);
+		if (tp->snd_cwnd < tp->snd_ssthresh)
+			tp->snd_ssthresh = tp->snd_cwnd;
+	} else if (signal && increase_law == RELENTLESS_INCREASE_SAMPLE &&
+		   tcp_is_cwnd_limited(sk)) {
+		relentless_sample_gain(ca, 1, sample_gain);
+		tp->snd_cwnd = relentless_fp_to_cwnd(ca->rtt_cwnd);
+	}
+
+	if (!before(tp->snd_una, ca->round_end_seq))
+		relentless_round_start(sk);
+}
+
+SEC(".struct_ops")
+struct tcp_congestion_ops relentless_bpf = {
+	.init		= (void *)relentless_bpf_init,
+	.ssthresh	= (void *)relentless_bpf_ssthresh,
+	.cong_avoid	= (void *)relentless_bpf_cong_avoid,
+	.cwnd_event	= (void *)relentless_bpf_cwnd_event,
+	.set_state	= (void *)relentless_bpf_set_state,
+	.undo_cwnd	= (void *)relentless_bpf_undo_cwnd,
+	.pkts_acked	= (void *)relentless_bpf_pkts_acked,
+	.name		= "relentless_bpf",
+};
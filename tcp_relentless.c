@@ -26,103 +26,931 @@
  */
 
 #include <linux/module.h>
+#include <linux/win_minmax.h>
+#include <linux/inet_diag.h>
+#include <linux/hashtable.h>
+#include <linux/jhash.h>
+#include <linux/percpu.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
+#include <linux/sysctl.h>
+#include <net/net_namespace.h>
+#include <net/netns/generic.h>
+#include <net/ipv6.h>
 #include <net/tcp.h>
 
-#define RELENTLESS_MAX_MARK 1024U
+#include "tcp_relentless.h"
+#include "tcp_relentless_compat.h"
+#include "tcp_relentless_core.h"
 
-static unsigned int markthresh __read_mostly = 174;
-module_param(markthresh, uint, 0644);
+#define CREATE_TRACE_POINTS
+#include "tcp_relentless_trace.h"
+
+/* Delivery rate is kept in packets per usec, scaled by 2^24 like BBR */
+#define RELENTLESS_BW_SCALE 24
+#define RELENTLESS_BW_UNIT (1 << RELENTLESS_BW_SCALE)
+
+#define RELENTLESS_GAIN_SCALE 10U
+
+/* Backoff laws, see backoff_mode */
+enum relentless_backoff {
+	RELENTLESS_BACKOFF_FIXED = 0,	/* backoff_gain per congested ACK */
+	RELENTLESS_BACKOFF_PROPORTIONAL = 1,	/* alpha / 2 per congested round */
+};
+
+/* alpha is in 1/1024ths, and is a 1/16 EWMA per round as in DCTCP */
+#define RELENTLESS_ALPHA_SHIFT 10U
+#define RELENTLESS_ALPHA_MAX (1U << RELENTLESS_ALPHA_SHIFT)
+#define RELENTLESS_ALPHA_G 4U
+
+/* HyStart style slowstart exit, as in tcp_cubic */
+#define HYSTART_ACK_TRAIN	0x1
+#define HYSTART_DELAY		0x2
+
+#define HYSTART_MIN_SAMPLES	8
+
+/* Tuning profiles selected by the socket mark, see profile_mark_mask */
+#define RELENTLESS_PROFILES	8
+
+/* Longest burst, in usecs at the pacing rate, a TSO minimum may add */
+#define RELENTLESS_TSO_BURST_US	2000U
+/* tso_burst before the first round has ended, and below min_tso_rate */
+#define RELENTLESS_TSO_BURST_UNKNOWN	0
+#define RELENTLESS_TSO_BURST_SLOW	1
+
+#define RELENTLESS_DST_HASH_BITS	10
+/* An entry counts as contended this long after one of its flows backed off */
+#define RELENTLESS_DST_CONG_AGE		HZ
+
+/*
+ * Parameters that can be tuned per network namespace, as
+ * net.ipv4.tcp_relentless_*.  The module parameters are the values of the
+ * initial namespace, and new namespaces start from a copy of them.
+ */
+struct relentless_params {
+	unsigned int markthresh;
+	unsigned int slowstart_rtt_observations_needed;
+	unsigned int rtt_min_win_sec;
+	unsigned int qdelay_floor_us;
+	unsigned int qdelay_target_us;
+};
+
+static struct relentless_params relentless_defaults __read_mostly = {
+	.markthresh = 174U,
+	.slowstart_rtt_observations_needed = 10U,
+	.rtt_min_win_sec = 10U,
+};
+
+/* Upper bound of the parameters each socket keeps a 16 bit copy of */
+static unsigned int relentless_u16_max = U16_MAX;
+
+/* Refuse values that do not fit, rather than clamping them per socket */
+static int relentless_param_set_u16(const char *val, const struct kernel_param *kp)
+{
+	unsigned int v;
+	int ret;
+
+	ret = kstrtouint(val, 0, &v);
+	if (ret)
+		return ret;
+	if (v > relentless_u16_max)
+		return -EINVAL;
+	*(unsigned int *)kp->arg = v;
+	return 0;
+}
+
+static const struct kernel_param_ops param_ops_relentless_u16 = {
+	.set = relentless_param_set_u16,
+	.get = param_get_uint,
+};
+#define param_check_relentless_u16(name, p) __param_check(name, p, unsigned int)
+
+module_param_named(markthresh, relentless_defaults.markthresh, relentless_u16, 0644);
 MODULE_PARM_DESC(markthresh, "rtts >  rtt_min + rtt_min * markthresh / 1024"
-		" are considered marks of congestion, defaults to 174 out of 1024");
+		" are considered marks of congestion, at most 65535, defaults to 174"
+		" out of 1024");
 
-static unsigned int slowstart_rtt_observations_needed __read_mostly = 10U;
-module_param(slowstart_rtt_observations_needed, uint, 0644);
+module_param_named(slowstart_rtt_observations_needed,
+		   relentless_defaults.slowstart_rtt_observations_needed, relentless_u16, 0644);
 MODULE_PARM_DESC(slowstart_rtt_observations_needed, "minimum number of RTT observations needed"
-		 " to exit slowstart, defaults to 10");
-
-static unsigned int debug_port __read_mostly = 5001;
-module_param(debug_port, int, 0644);
-MODULE_PARM_DESC(debug_port, "Port to match for debugging (0=all)");
-
-static unsigned int debug_src __read_mostly = 167772162; // 10.0.0.2
-module_param(debug_src, int, 0644);
-MODULE_PARM_DESC(debug_src, "Source IP address to match for debugging (0=all)");
-
-/* Relentless structure */
-struct relentless {
-	u32 save_cwnd;     /* saved cwnd from before disorder or recovery */
-	u32 cwndnlosses;   /* ditto plus total losses todate */
-	u32 rtts_observed;
-	u32 rtt_min;
-	u32 rtt_thresh;
-	u32 rtt_cwnd;      /* cwnd scaled by 1024 */
-	bool debug;
+		 " to exit slowstart, at most 65535, defaults to 10");
+
+module_param_named(rtt_min_win_sec, relentless_defaults.rtt_min_win_sec, uint, 0644);
+MODULE_PARM_DESC(rtt_min_win_sec, "length of the windowed rtt_min filter in seconds,"
+		 " defaults to 10");
+
+module_param_named(qdelay_floor_us, relentless_defaults.qdelay_floor_us, relentless_u16, 0644);
+MODULE_PARM_DESC(qdelay_floor_us, "queueing delay in usecs tolerated even when"
+		 " rtt_min * markthresh / 1024 is smaller, at most 65535, defaults to 0");
+
+module_param_named(qdelay_target_us, relentless_defaults.qdelay_target_us, relentless_u16, 0644);
+MODULE_PARM_DESC(qdelay_target_us, "queueing delay in usecs tolerated at most, whatever"
+		 " rtt_min, at most 65535, defaults to 0 (no limit)");
+
+/*
+ * Aggregate counters, summed over the CPUs in /proc/net/relentless.  The
+ * histograms are log2: bucket i holds values from 2^(i-1) up to 2^i - 1,
+ * bucket 0 holds 0 and the last bucket everything above.  rtt_cwnd is
+ * counted once per flow and round in packets, the queueing delay (RTT
+ * minus rtt_min) once per RTT sample in usecs.
+ */
+enum {
+	RELENTLESS_STAT_BACKOFFS,
+	RELENTLESS_STAT_SS_EXITS,
+	RELENTLESS_STAT_CWR_COMPLETIONS,
+	RELENTLESS_STAT_RTO_RESETS,
+	RELENTLESS_STAT_MAX
+};
+
+static const char *const relentless_stat_names[RELENTLESS_STAT_MAX] = {
+	[RELENTLESS_STAT_BACKOFFS]		= "backoffs",
+	[RELENTLESS_STAT_SS_EXITS]		= "slowstart_exits",
+	[RELENTLESS_STAT_CWR_COMPLETIONS]	= "cwr_completions",
+	[RELENTLESS_STAT_RTO_RESETS]		= "rto_resets",
+};
+
+#define RELENTLESS_CWND_BUCKETS		16
+#define RELENTLESS_QDELAY_BUCKETS	20
+
+struct relentless_stats {
+	unsigned long cnt[RELENTLESS_STAT_MAX];
+	unsigned long rtt_cwnd[RELENTLESS_CWND_BUCKETS];
+	unsigned long qdelay_us[RELENTLESS_QDELAY_BUCKETS];
+};
+
+struct relentless_net {
+	struct relentless_params *params; /* &relentless_defaults or &ns_params */
+	struct relentless_params ns_params;
+	struct ctl_table_header *sysctl_header;
+	struct relentless_stats __percpu *stats;
+};
+
+static unsigned int relentless_net_id __read_mostly;
+
+static const struct relentless_params *relentless_params(const struct sock *sk)
+{
+	const struct relentless_net *rn = net_generic(sock_net(sk), relentless_net_id);
+
+	return rn->params;
+}
+
+static struct relentless_stats __percpu *relentless_stats(const struct sock *sk)
+{
+	const struct relentless_net *rn = net_generic(sock_net(sk), relentless_net_id);
+
+	return rn->stats;
+}
+
+static void relentless_stat_inc(const struct sock *sk, int stat)
+{
+	this_cpu_inc(relentless_stats(sk)->cnt[stat]);
+}
+
+static int relentless_stat_bucket(u32 val, int buckets)
+{
+	return min(fls(val), buckets - 1);
+}
+
+/* Count val in the bucket of the named histogram, on this CPU */
+#define relentless_stat_hist(sk, hist, buckets, val) \
+	this_cpu_inc(relentless_stats(sk)->hist[relentless_stat_bucket(val, buckets)])
+
+static unsigned int profile_mark_mask __read_mostly;
+module_param(profile_mark_mask, uint, 0644);
+MODULE_PARM_DESC(profile_mark_mask, "socket mark bits selecting one of 8 tuning profiles,"
+		 " defaults to 0 (no profiles)");
+
+static unsigned int profile_markthresh[RELENTLESS_PROFILES] __read_mostly;
+module_param_array(profile_markthresh, relentless_u16, NULL, 0644);
+MODULE_PARM_DESC(profile_markthresh, "markthresh for each profile, 0 uses markthresh");
+
+static unsigned int profile_slowstart_rtt_observations[RELENTLESS_PROFILES] __read_mostly;
+module_param_array(profile_slowstart_rtt_observations, relentless_u16, NULL, 0644);
+MODULE_PARM_DESC(profile_slowstart_rtt_observations, "slowstart_rtt_observations_needed for"
+		 " each profile, 0 uses slowstart_rtt_observations_needed");
+
+static unsigned int profile_qdelay_floor_us[RELENTLESS_PROFILES] __read_mostly;
+module_param_array(profile_qdelay_floor_us, relentless_u16, NULL, 0644);
+MODULE_PARM_DESC(profile_qdelay_floor_us, "qdelay_floor_us for each profile,"
+		 " 0 uses qdelay_floor_us");
+
+static unsigned int profile_qdelay_target_us[RELENTLESS_PROFILES] __read_mostly;
+module_param_array(profile_qdelay_target_us, relentless_u16, NULL, 0644);
+MODULE_PARM_DESC(profile_qdelay_target_us, "qdelay_target_us for each profile,"
+		 " 0 uses qdelay_target_us");
+
+static unsigned int increase_law __read_mostly = RELENTLESS_INCREASE_RENO;
+module_param(increase_law, uint, 0644);
+MODULE_PARM_DESC(increase_law, "window increase after slowstart: 0=per RTT sample below"
+		 " rtt_thresh (no slowstart), 1=reno, 2=scalable, defaults to 1");
+
+static unsigned int hystart_detect __read_mostly = HYSTART_ACK_TRAIN | HYSTART_DELAY;
+module_param(hystart_detect, uint, 0644);
+MODULE_PARM_DESC(hystart_detect, "slowstart exit detection: 1=ACK train, 2=per round min RTT"
+		 " above rtt_thresh, 3=both (default), 0=off");
+
+static unsigned int hystart_low_window __read_mostly = 16U;
+module_param(hystart_low_window, uint, 0644);
+MODULE_PARM_DESC(hystart_low_window, "lower bound cwnd for hybrid slow start, defaults to 16");
+
+static unsigned int hystart_ack_delta_us __read_mostly = 2000U;
+module_param(hystart_ack_delta_us, uint, 0644);
+MODULE_PARM_DESC(hystart_ack_delta_us, "max spacing between ACKs of an ACK train in usecs,"
+		 " defaults to 2000");
+
+static unsigned int backoff_gain __read_mostly = 64U;
+module_param(backoff_gain, uint, 0644);
+MODULE_PARM_DESC(backoff_gain, "rtt_cwnd decrease per acked packet on a congestion signal,"
+		 " in 1/1024 packets, defaults to 64");
+
+static unsigned int backoff_mode __read_mostly = RELENTLESS_BACKOFF_FIXED;
+module_param(backoff_mode, uint, 0644);
+MODULE_PARM_DESC(backoff_mode, "0=fixed backoff_gain per congested ACK, 1=proportional to"
+		 " the excess delay (or mark fraction) averaged over a round, defaults to 0");
+
+static unsigned int sample_gain __read_mostly = RELENTLESS_CWND_ONE;
+module_param(sample_gain, uint, 0644);
+MODULE_PARM_DESC(sample_gain, "rtt_cwnd increase per uncongested RTT sample with"
+		 " increase_law=0, in 1/1024 packets, defaults to 1024");
+
+static unsigned int rtt_filter_samples __read_mostly = 1;
+module_param(rtt_filter_samples, uint, 0644);
+MODULE_PARM_DESC(rtt_filter_samples, "RTT samples in a row that must exceed rtt_thresh"
+		 " before each backs off, 1-7, defaults to 1");
+
+static bool round_updates __read_mostly;
+module_param(round_updates, bool, 0644);
+MODULE_PARM_DESC(round_updates, "update rtt_min, the congestion decision and rtt_cwnd once per"
+		 " round trip instead of per ACK, defaults to off");
+
+static bool ecn __read_mostly;
+module_param(ecn, bool, 0444);
+MODULE_PARM_DESC(ecn, "negotiate ECN and back off on CE marks instead of rtt_thresh"
+		 " when the peer agrees, defaults to off");
+
+static unsigned int pacing_gain __read_mostly = 1280U;
+module_param(pacing_gain, uint, 0644);
+MODULE_PARM_DESC(pacing_gain, "relentless_rate paces at delivery rate * pacing_gain / 1024,"
+		 " defaults to 1280 out of 1024");
+
+static unsigned int pacing_ss_gain __read_mostly = 2048U;
+module_param(pacing_ss_gain, uint, 0644);
+MODULE_PARM_DESC(pacing_ss_gain, "pacing gain out of 1024 used during slowstart,"
+		 " defaults to 2048");
+
+static unsigned int min_tso_rate __read_mostly = 1200000U;
+module_param(min_tso_rate, uint, 0644);
+MODULE_PARM_DESC(min_tso_rate, "below this pacing rate in bits/sec send single segment"
+		 " skbs, defaults to 1200000");
+
+static unsigned int tso_cwnd_shift __read_mostly = 4U;
+module_param(tso_cwnd_shift, uint, 0644);
+MODULE_PARM_DESC(tso_cwnd_shift, "size TSO bursts up to rtt_cwnd >> tso_cwnd_shift segments,"
+		 " 0 keeps the stack's tcp_min_tso_segs, defaults to 4 (1/16)");
+
+static bool dst_cache __read_mostly;
+module_param(dst_cache, bool, 0644);
+MODULE_PARM_DESC(dst_cache, "share rtt_min and the window between connections to the same"
+		 " destination, defaults to off");
+
+static unsigned int dst_cache_size __read_mostly = 4096U;
+module_param(dst_cache_size, uint, 0644);
+MODULE_PARM_DESC(dst_cache_size, "most destinations in the cache, defaults to 4096");
+
+static unsigned int dst_init_cwnd_max __read_mostly = 64U;
+module_param(dst_init_cwnd_max, uint, 0644);
+MODULE_PARM_DESC(dst_init_cwnd_max, "largest initial window taken from the destination cache,"
+		 " defaults to 64");
+
+static unsigned int dst_save_timeout_sec __read_mostly = 60U;
+module_param(dst_save_timeout_sec, uint, 0644);
+MODULE_PARM_DESC(dst_save_timeout_sec, "seed from the window of a closed connection for this"
+		 " many seconds, 0 to not seed from closed connections, defaults to 60");
+
+/*
+ * A round trip ends when the data sent at its start has been cumulatively
+ * acked.  HyStart, the per round and proportional backoffs and the delivery
+ * rate filter all run off this one round.
+ */
+static void relentless_round_start(struct sock *sk)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct relentless *ca = inet_csk_ca(sk);
+
+	relentless_round_reset(ca, tp->snd_nxt, (u32)tp->tcp_mstamp);
+}
+
+/*
+ * Per destination cache, with dst_cache=1.  Connections to the same peer,
+ * keyed by namespace and destination address as in tcp_metrics, publish
+ * their rtt_min and window once per round.  A new connection takes the
+ * cached rtt_min as already observed, so it leaves slowstart on its first
+ * RTTs over rtt_thresh instead of overshooting while it measures, and
+ * starts at an equal share of the windows the flows already there hold,
+ * at most dst_init_cwnd_max packets.  While the entry is contended (one of
+ * its flows backed off or lost packets in the last second) each of its
+ * flows grows by 1 / flows packets per round, so together they probe like
+ * one flow and the bottleneck holds one flow's standing queue instead of
+ * one per flow.
+ *
+ * A closing connection saves its window, so the next one starts from it
+ * when no other flow is running.  Short request/response connections then
+ * reach their rate in a round or two instead of slowstarting from the
+ * initial window every time.
+ *
+ * Readers are under RCU; joining, eviction and namespace exit take
+ * relentless_dst_lock.  Only entries without connections are evicted.
+ */
+struct relentless_dst {
+	struct hlist_node	node;
+	struct rcu_head		rcu;
+	possible_net_t		net;
+	u32			addr[4];	/* IPv4 in addr[0] */
+	u16			family;
+	atomic_t		flows;		/* connections using the entry */
+	u32			rtt_min;	/* usecs */
+	u32			rtt_min_stamp;	/* tcp_jiffies32 it was measured at */
+	atomic_t		cwnd_sum;	/* of the flows' published windows */
+	u32			cong_stamp;	/* tcp_jiffies32 a flow last backed off */
+	u32			saved_cwnd;	/* window of the last closed flow */
+	u32			saved_stamp;	/* tcp_jiffies32 it closed at */
+	u32			last_use;	/* tcp_jiffies32 */
 };
 
-inline static void relentless_init(struct sock *sk)
+static bool relentless_dst_lower(const struct relentless *ca)
+{
+	return !ca->backoffs && !ca->save_cwnd;
+}
+
+static bool relentless_dst_contended(const struct relentless_dst *d)
+{
+	return (s32)(tcp_jiffies32 - READ_ONCE(d->cong_stamp)) <= (s32)RELENTLESS_DST_CONG_AGE;
+}
+
+static bool relentless_dst_saved(const struct relentless_dst *d)
+{
+	u32 timeout = READ_ONCE(dst_save_timeout_sec) * HZ;
+
+	return READ_ONCE(d->saved_cwnd) &&
+	       (s32)(tcp_jiffies32 - READ_ONCE(d->saved_stamp)) <= (s32)timeout;
+}
+
+static DEFINE_HASHTABLE(relentless_dst_hash, RELENTLESS_DST_HASH_BITS);
+static DEFINE_SPINLOCK(relentless_dst_lock);
+static unsigned int relentless_dst_count;
+
+static u32 relentless_dst_key(const struct sock *sk, u32 addr[4], u16 *family)
+{
+	memset(addr, 0, 4 * sizeof(u32));
+#if IS_ENABLED(CONFIG_IPV6)
+	if (sk->sk_family == AF_INET6 && !ipv6_addr_v4mapped(&sk->sk_v6_daddr)) {
+		memcpy(addr, sk->sk_v6_daddr.s6_addr32, 4 * sizeof(u32));
+		*family = AF_INET6;
+		return jhash2(addr, 4, net_hash_mix(sock_net(sk)));
+	}
+#endif
+	addr[0] = inet_sk(sk)->inet_daddr;
+	*family = AF_INET;
+	return jhash2(addr, 4, net_hash_mix(sock_net(sk)));
+}
+
+/* Under rcu_read_lock() */
+static struct relentless_dst *relentless_dst_find(const struct net *net, const u32 addr[4],
+						  u16 family, u32 hash)
+{
+	struct relentless_dst *d;
+
+	hash_for_each_possible_rcu(relentless_dst_hash, d, node, hash) {
+		if (d->family == family && net_eq(read_pnet(&d->net), net) &&
+		    !memcmp(d->addr, addr, sizeof(d->addr)))
+			return d;
+	}
+	return NULL;
+}
+
+/* Under relentless_dst_lock.  When full, replace the stalest idle entry of the bucket. */
+static struct relentless_dst *relentless_dst_create(struct net *net, const u32 addr[4],
+						    u16 family, u32 hash)
+{
+	struct relentless_dst *d, *victim = NULL;
+
+	if (relentless_dst_count >= READ_ONCE(dst_cache_size)) {
+		hash_for_each_possible(relentless_dst_hash, d, node, hash) {
+			if (!atomic_read(&d->flows) &&
+			    (!victim || (s32)(d->last_use - victim->last_use) < 0))
+				victim = d;
+		}
+		if (!victim)
+			return NULL;
+		hash_del_rcu(&victim->node);
+		kfree_rcu(victim, rcu);
+		relentless_dst_count--;
+	}
+
+	d = kzalloc(sizeof(*d), GFP_ATOMIC);
+	if (!d)
+		return NULL;
+	write_pnet(&d->net, net);
+	memcpy(d->addr, addr, sizeof(d->addr));
+	d->family = family;
+	d->last_use = tcp_jiffies32;
+	hash_add_rcu(relentless_dst_hash, &d->node, hash);
+	relentless_dst_count++;
+	return d;
+}
+
+/* Seed a new connection from the flows already using d */
+static void relentless_dst_seed(struct sock *sk, const struct relentless_dst *d, u32 flows)
 {
 	struct tcp_sock *tp = tcp_sk(sk);
 	struct relentless *ca = inet_csk_ca(sk);
+	u32 win = READ_ONCE(relentless_params(sk)->rtt_min_win_sec) * HZ;
+	u32 rtt_min = READ_ONCE(d->rtt_min);
+	u32 stamp = READ_ONCE(d->rtt_min_stamp);
+	u32 sum = max(atomic_read(&d->cwnd_sum), 0);
+	u32 share = 0;
+
+	if (rtt_min && (s32)(tcp_jiffies32 - stamp) <= (s32)win) {
+		minmax_reset(&ca->rtt_min, stamp, rtt_min);
+		ca->rtt_thresh = relentless_rtt_thresh(ca, rtt_min);
+		ca->rtts_observed = ca->rtt_observations_needed;
+	}
+
+	if (sum)
+		share = sum / flows;
+	else if (relentless_dst_saved(d))
+		share = READ_ONCE(d->saved_cwnd);
+
+	/*
+	 * Only the initial window is seeded.  With rtt_min known slowstart
+	 * ends on the first RTTs over rtt_thresh, which finds the share
+	 * better than windows that may predate the flows there now.
+	 */
+	if (share <= relentless_snd_cwnd(tp))
+		return;
+	relentless_snd_cwnd_set(tp, min3(share, max(READ_ONCE(dst_init_cwnd_max), relentless_snd_cwnd(tp)),
+				  tp->snd_cwnd_clamp));
+	ca->rtt_cwnd = relentless_cwnd_to_fp(relentless_snd_cwnd(tp));
+}
+
+static void relentless_dst_join(struct sock *sk)
+{
+	struct relentless *ca = inet_csk_ca(sk);
+	struct relentless_dst *d;
+	struct net *net = sock_net(sk);
+	u32 addr[4], hash, flows;
+	u16 family;
+
+	ca->dst_flows = 1;
+	if (!READ_ONCE(dst_cache))
+		return;
+
+	hash = relentless_dst_key(sk, addr, &family);
+	rcu_read_lock();
+	spin_lock_bh(&relentless_dst_lock);
+	d = relentless_dst_find(net, addr, family, hash);
+	if (!d)
+		d = relentless_dst_create(net, addr, family, hash);
+	if (d) {
+		ca->dst_joined = 1;
+		flows = atomic_inc_return(&d->flows);
+		if (relentless_dst_contended(d))
+			ca->dst_flows = min_t(u32, flows, U8_MAX);
+		relentless_dst_seed(sk, d, flows);
+		WRITE_ONCE(d->last_use, tcp_jiffies32);
+	}
+	spin_unlock_bh(&relentless_dst_lock);
+	rcu_read_unlock();
+}
+
+/* Once per round: publish this flow's rtt_min and window, learn the flow count */
+static void relentless_dst_update(struct sock *sk)
+{
+	struct relentless *ca = inet_csk_ca(sk);
+	u32 win = READ_ONCE(relentless_params(sk)->rtt_min_win_sec) * HZ;
+	struct relentless_dst *d;
+	u32 addr[4], hash;
+	u16 family;
+
+	if (!ca->dst_joined)
+		return;
+
+	hash = relentless_dst_key(sk, addr, &family);
+	rcu_read_lock();
+	d = relentless_dst_find(sock_net(sk), addr, family, hash);
+	if (d) {
+		u32 rtt_min = minmax_get(&ca->rtt_min);
+		u32 d_rtt_min = READ_ONCE(d->rtt_min);
+		u32 stamp = READ_ONCE(d->rtt_min_stamp);
+		bool fresh = d_rtt_min && (s32)(tcp_jiffies32 - stamp) <= (s32)win;
+		u32 cwnd = min(relentless_fp_to_cwnd(ca->rtt_cwnd), (u32)U16_MAX);
+		bool contended;
+
+		/*
+		 * The filter keeps when its min was measured, so seeds do not
+		 * refresh it.  A flow that came in on a standing queue learns
+		 * the lower rtt_min of the others.
+		 */
+		if (fresh && d_rtt_min < rtt_min) {
+			minmax_reset(&ca->rtt_min, stamp, d_rtt_min);
+			ca->rtt_thresh = relentless_rtt_thresh(ca, d_rtt_min);
+		} else if (ca->rtts_observed >= ca->rtt_observations_needed &&
+			   (!fresh || rtt_min <= d_rtt_min)) {
+			WRITE_ONCE(d->rtt_min, rtt_min);
+			WRITE_ONCE(d->rtt_min_stamp, ca->rtt_min.s[0].t);
+		}
+		atomic_add((int)cwnd - ca->dst_cwnd, &d->cwnd_sum);
+		ca->dst_cwnd = cwnd;
+
+		/* backed off or lost packets since the last round */
+		if (ca->backoffs != ca->dst_backoffs ||
+		    inet_csk(sk)->icsk_ca_state >= TCP_CA_Recovery)
+			WRITE_ONCE(d->cong_stamp, tcp_jiffies32);
+		ca->dst_backoffs = ca->backoffs;
+		contended = relentless_dst_contended(d);
+
+		WRITE_ONCE(d->last_use, tcp_jiffies32);
+		ca->dst_flows = contended ? clamp_t(u32, atomic_read(&d->flows), 1, U8_MAX) : 1;
+	}
+	rcu_read_unlock();
+}
+
+/* Drop out of the entry, saving the window for the next connection */
+static void relentless_dst_leave(struct sock *sk)
+{
+	struct relentless *ca = inet_csk_ca(sk);
+	u32 cwnd = relentless_fp_to_cwnd(ca->rtt_cwnd);
+	bool lower = relentless_dst_lower(ca);
+	struct relentless_dst *d;
+	u32 addr[4], hash;
+	u16 family;
+
+	if (!ca->dst_joined)
+		return;
+	ca->dst_joined = 0;
+
+	hash = relentless_dst_key(sk, addr, &family);
+	rcu_read_lock();
+	d = relentless_dst_find(sock_net(sk), addr, family, hash);
+	if (d) {
+		/* a short transfer may have learned less than the last one */
+		if (ca->rtts_observed &&
+		    !(lower && relentless_dst_saved(d) && cwnd <= READ_ONCE(d->saved_cwnd))) {
+			WRITE_ONCE(d->saved_cwnd, cwnd);
+			WRITE_ONCE(d->saved_stamp, tcp_jiffies32);
+		}
+		atomic_sub(ca->dst_cwnd, &d->cwnd_sum);
+		atomic_dec(&d->flows);
+	}
+	rcu_read_unlock();
+}
+
+static void relentless_dst_flush(struct net *net)
+{
+	struct relentless_dst *d;
+	struct hlist_node *tmp;
+	int bkt;
+
+	spin_lock_bh(&relentless_dst_lock);
+	hash_for_each_safe(relentless_dst_hash, bkt, tmp, d, node) {
+		if (!net_eq(read_pnet(&d->net), net))
+			continue;
+		hash_del_rcu(&d->node);
+		kfree_rcu(d, rcu);
+		relentless_dst_count--;
+	}
+	spin_unlock_bh(&relentless_dst_lock);
+}
+
 /*
-	const struct inet_sock *inet = inet_sk(sk);
-	u32 saddr = be32_to_cpu(inet->inet_saddr);
+ * Capture the tuning parameters for this connection.  A sockops BPF program
+ * can pick a profile per destination by setting SO_MARK before the
+ * connection is established (or before selecting relentless with
+ * TCP_CONGESTION), and so can the application.
  */
+static void relentless_init_params(struct sock *sk)
+{
+	struct relentless *ca = inet_csk_ca(sk);
+	const struct relentless_params *params = relentless_params(sk);
+	u32 thresh = READ_ONCE(params->markthresh);
+	u32 needed = READ_ONCE(params->slowstart_rtt_observations_needed);
+	u32 floor = READ_ONCE(params->qdelay_floor_us);
+	u32 target = READ_ONCE(params->qdelay_target_us);
+	u32 mask = READ_ONCE(profile_mark_mask);
+
+	if (mask) {
+		u32 profile = (READ_ONCE(sk->sk_mark) & mask) >> __ffs(mask);
+
+		if (profile < RELENTLESS_PROFILES) {
+			if (READ_ONCE(profile_markthresh[profile]))
+				thresh = READ_ONCE(profile_markthresh[profile]);
+			if (READ_ONCE(profile_slowstart_rtt_observations[profile]))
+				needed = READ_ONCE(profile_slowstart_rtt_observations[profile]);
+			if (READ_ONCE(profile_qdelay_floor_us[profile]))
+				floor = READ_ONCE(profile_qdelay_floor_us[profile]);
+			if (READ_ONCE(profile_qdelay_target_us[profile]))
+				target = READ_ONCE(profile_qdelay_target_us[profile]);
+		}
+	}
+
+	ca->markthresh = min_t(u32, thresh, U16_MAX);
+	ca->rtt_observations_needed = min_t(u32, needed, U16_MAX);
+	ca->qdelay_floor_us = min_t(u32, floor, U16_MAX);
+	ca->qdelay_target_us = min_t(u32, target, U16_MAX);
+}
+
+static void relentless_init(struct sock *sk)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct relentless *ca = inet_csk_ca(sk);
+
+	relentless_init_params(sk);
+
 	ca->save_cwnd = 0;
 	ca->cwndnlosses = 0;
 
 	ca->rtts_observed = 0;
-	ca->rtt_min = USEC_PER_SEC;
-	ca->rtt_cwnd = tp->snd_cwnd << 10U;
+	ca->backoffs = 0;
+	ca->rtt_over = 0;
+	minmax_reset(&ca->rtt_min, tcp_jiffies32, USEC_PER_SEC);
+	ca->rtt_thresh = USEC_PER_SEC;
+	ca->rtt_cwnd = relentless_cwnd_to_fp(relentless_snd_cwnd(tp));
+
+	ca->bw = 0;
+	ca->prior_bw = 0;
+
+	relentless_round_start(sk);
+
+	ca->ce_state = 0;
+	ca->ece = 0;
+	ca->prior_rcv_nxt = tp->rcv_nxt;
+
+	ca->alpha = 0;
+	ca->tso_burst = RELENTLESS_TSO_BURST_UNKNOWN;
+
+	relentless_dst_join(sk);
+
+	trace_relentless_init(sk, minmax_get(&ca->rtt_min), ca->rtt_thresh, 0,
+			      ca->rtt_cwnd);
+}
+
+static void relentless_release(struct sock *sk)
+{
+	relentless_dst_update(sk);
+	relentless_dst_leave(sk);
+}
 
-        ca->debug = false;
 /*
-	pr_info("dctcp: saddr=%u\n", saddr);
-        if (debug_port == 0 || ((ntohs(inet->inet_dport) == debug_port) && saddr == debug_src))
-                ca->debug = true;
+ * Grow cwnd by slowstart, then by the selected increase law.  rtt_cwnd moves
+ * by the same amount, so fractions left by delay backoffs are kept.  Flows
+ * sharing a destination cache entry split the increase between them.
  */
+static void relentless_increase(struct sock *sk, u32 acked)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct relentless *ca = inet_csk_ca(sk);
+	u32 prior_cwnd = relentless_snd_cwnd(tp);
+	u32 flows = max_t(u32, ca->dst_flows, 1);
 
-	pr_info("relentless init: rtt_cwnd=%u\n", ca->rtt_cwnd);
+	/* In "safe" area, increase. */
+	if (tcp_in_slow_start(tp)) {
+		acked = tcp_slow_start(tp, acked);
+		if (!acked)
+			goto done;
+	}
+
+	/* In dangerous area, increase slowly. */
+	tcp_cong_avoid_ai(tp, relentless_ai_cnt(increase_law, relentless_snd_cwnd(tp), flows),
+			  acked);
+done:
+	relentless_rtt_cwnd_add(ca, ((s64)relentless_snd_cwnd(tp) - prior_cwnd) * RELENTLESS_CWND_ONE);
 }
 
-void relentless_cong_avoid(struct sock *sk, u32 ack, u32 acked)
+/*
+ * Nothing is learnt about the path from ACKs for data sent while rwnd or
+ * application limited, so then cwnd neither grows nor raises the snapshot.
+ */
+static void relentless_update_cwnd(struct sock *sk, u32 acked, bool cwnd_limited)
 {
 	struct tcp_sock *tp = tcp_sk(sk);
 	struct relentless *ca = inet_csk_ca(sk);
 
 	/* defeat all policy based cwnd reductions */
-	tp->snd_cwnd = max(tp->snd_cwnd, tcp_packets_in_flight(tp));
-
-//	if (!tcp_is_cwnd_limited(sk))
-//		return;
-//
-//	/* In "safe" area, increase. */
-//	if (tcp_in_slow_start(tp)) {
-//		acked = tcp_slow_start(tp, acked);
-//		ca->rtt_cwnd = tp->snd_cwnd << 10U;
-//		if (ca->debug)
-//			pr_info_ratelimited("relentless slow start: rtt_cwnd=%u, cwnd=%u, ssthresh=%u\n",
-//				ca->rtt_cwnd, tp->snd_cwnd, tp->snd_ssthresh);
-//		if (!acked)
-//			return;
-//	}
-//	/* In dangerous area, increase slowly. */
-//	tcp_cong_avoid_ai(tp, tp->snd_cwnd, acked);
-//	ca->rtt_cwnd = tp->snd_cwnd << 10U;
-//
-//	if (ca->debug)
-//		pr_info_ratelimited("relentless cong avoid: rtt_cwnd=%u, cwnd=%u, ssthresh=%u\n",
-//			ca->rtt_cwnd, tp->snd_cwnd, tp->snd_ssthresh);
-
-	ca->save_cwnd = tp->snd_cwnd;
-	ca->cwndnlosses = tp->snd_cwnd + tp->total_retrans;
-}
-
-/* Slow start threshold follows cwnd, to defeat slowstart and cwnd moderation, etc */
+	relentless_snd_cwnd_set(tp, max(relentless_snd_cwnd(tp), tcp_packets_in_flight(tp)));
+
+	if (increase_law != RELENTLESS_INCREASE_SAMPLE && cwnd_limited)
+		relentless_increase(sk, acked);
+
+	relentless_open_snapshot(ca, inet_csk(sk)->icsk_ca_state, relentless_snd_cwnd(tp),
+				 tp->lost, cwnd_limited);
+}
+
+static void relentless_cong_avoid(struct sock *sk, u32 ack, u32 acked)
+{
+	relentless_update_cwnd(sk, acked, tcp_is_cwnd_limited(sk));
+}
+
+/* Slow start threshold follows cwnd, to defeat slowstart and cwnd moderation, etc. */
 static u32 relentless_ssthresh(struct sock *sk)
 {
 	const struct tcp_sock *tp = tcp_sk(sk);
 
-	return max(tp->snd_cwnd, 2U);	/* Done already */
+	return relentless_cwnd_ssthresh(relentless_snd_cwnd(tp), tp->lost_out);
+}
+
+/*
+ * The recovery or RTO was spurious (DSACK, F-RTO, timestamps), so put back
+ * the window saved before it, and bring rtt_cwnd up with it so the next
+ * delay backoff does not drop straight back to the reduced window.
+ */
+static u32 relentless_undo_cwnd(struct sock *sk)
+{
+	struct relentless *ca = inet_csk_ca(sk);
+
+	ca->undone = 1;
+	return relentless_undo(ca, relentless_snd_cwnd(tcp_sk(sk)));
+}
+
+static void relentless_set_pacing_rate(struct sock *sk, u32 gain)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct relentless *ca = inet_csk_ca(sk);
+	u32 bw = max(ca->bw, ca->prior_bw);
+	u64 rate;
+
+	if (bw) {
+		/* USEC_PER_SEC == 15625 << 6, split to keep the product in 64 bits */
+		rate = (u64)bw * tp->mss_cache;
+		rate = (rate * gain) >> RELENTLESS_GAIN_SCALE;
+		rate = (rate * (USEC_PER_SEC >> 6)) >> (RELENTLESS_BW_SCALE - 6);
+	} else if (tp->srtt_us) {
+		/* No delivery rate yet, fall back to cwnd / srtt */
+		rate = (u64)tp->mss_cache * relentless_snd_cwnd(tp) * (USEC_PER_SEC << 3);
+		rate = div_u64((rate * gain) >> RELENTLESS_GAIN_SCALE, tp->srtt_us);
+	} else {
+		return;
+	}
+
+	WRITE_ONCE(sk->sk_pacing_rate,
+		   min_t(u64, rate, READ_ONCE(sk->sk_max_pacing_rate)));
+}
+
+/*
+ * The segments RELENTLESS_TSO_BURST_US at the pacing rate carries, at least
+ * 2, or RELENTLESS_TSO_BURST_SLOW below min_tso_rate.  The stack or relentless_set_pacing_rate()
+ * update the rate on every ACK and min_tso_segs is asked for every skb, so
+ * the divisions are done here once per round instead.  The rate is capped
+ * to 32 bits of bytes/sec to keep the product in 64 bits, which is still
+ * far above any GSO limit.
+ */
+static void relentless_tso_burst_update(struct sock *sk)
+{
+	const struct tcp_sock *tp = tcp_sk(sk);
+	struct relentless *ca = inet_csk_ca(sk);
+	unsigned long rate = READ_ONCE(sk->sk_pacing_rate);
+	u32 burst;
+
+	if (!tp->mss_cache) {
+		ca->tso_burst = RELENTLESS_TSO_BURST_UNKNOWN;
+		return;
+	}
+	if (rate < (READ_ONCE(min_tso_rate) >> 3)) {
+		ca->tso_burst = RELENTLESS_TSO_BURST_SLOW;
+		return;
+	}
+
+	burst = div_u64((u64)min_t(unsigned long, rate, U32_MAX) *
+			RELENTLESS_TSO_BURST_US, USEC_PER_SEC) / tp->mss_cache;
+	ca->tso_burst = clamp_t(u32, burst, 2, U16_MAX);
+}
+
+/*
+ * tcp_tso_autosize() already sizes skbs to about 1ms at the pacing rate; this
+ * raises the floor to a fraction of rtt_cwnd so that fewer, larger segments
+ * go out when the window is big relative to that, never beyond the burst
+ * relentless_tso_burst_update() allows.
+ */
+static u32 relentless_min_tso_segs(struct sock *sk)
+{
+	const struct relentless *ca = inet_csk_ca(sk);
+	u32 shift = READ_ONCE(tso_cwnd_shift);
+
+	if (ca->tso_burst == RELENTLESS_TSO_BURST_SLOW)
+		return 1;
+	/* what the stack uses without the hook, until a round has ended */
+	if (ca->tso_burst == RELENTLESS_TSO_BURST_UNKNOWN || !shift)
+		return READ_ONCE(sock_net(sk)->ipv4.sysctl_tcp_min_tso_segs);
+
+	shift = min(shift + RELENTLESS_CWND_SHIFT, 31U);
+	return clamp_t(u32, ca->rtt_cwnd >> shift, 2, ca->tso_burst);
+}
+
+/*
+ * The stack grows sndbuf to twice cwnd.  Pacing above the delivery rate
+ * needs room for the extra gain on top, rounded up to whole windows.  The
+ * stock ops are paced by the kernel's own ratios, which sit close to ours.
+ */
+static u32 relentless_sndbuf_expand(struct sock *sk)
+{
+	u32 gain = tcp_in_slow_start(tcp_sk(sk)) ? READ_ONCE(pacing_ss_gain) :
+						    READ_ONCE(pacing_gain);
+
+	return max(DIV_ROUND_UP(gain, 1U << RELENTLESS_GAIN_SCALE) + 1, 2U);
+}
+
+/*
+ * Sending again with nothing in flight.  After a real idle period, keep the
+ * window instead of bursting it or collapsing it: when the flow is paced
+ * (relentless_rate, or an fq qdisc) restore cwnd from rtt_cwnd and, in
+ * relentless_rate, send it at the last measured delivery rate until new
+ * ACKs update the rate.  Unpaced flows keep the stack's slow start after
+ * idle, and rtt_cwnd follows cwnd down so the next backoff cannot jump
+ * back to the old window in one burst.
+ */
+static void relentless_idle_restart(struct sock *sk)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct relentless *ca = inet_csk_ca(sk);
+
+	if (tcp_jiffies32 == tp->lsndtime)
+		return;
+
+	if (sk->sk_pacing_status != SK_PACING_NONE) {
+		relentless_snd_cwnd_set(tp, min(max(relentless_snd_cwnd(tp),
+					     relentless_fp_to_cwnd(ca->rtt_cwnd)),
+					 tp->snd_cwnd_clamp));
+		if (inet_csk(sk)->icsk_ca_ops->cong_control)
+			relentless_set_pacing_rate(sk, 1U << RELENTLESS_GAIN_SCALE);
+	} else {
+		ca->rtt_cwnd = min(ca->rtt_cwnd, relentless_cwnd_to_fp(relentless_snd_cwnd(tp)));
+	}
+
+	relentless_round_start(sk);
+}
+
+static bool relentless_ecn_ok(const struct sock *sk)
+{
+	return ecn && (tcp_sk(sk)->ecn_flags & TCP_ECN_OK);
+}
+
+static void relentless_ece_ack_cwr(struct sock *sk, u32 ce_state)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+
+	if (ce_state)
+		tp->ecn_flags |= TCP_ECN_DEMAND_CWR;
+	else
+		tp->ecn_flags &= ~TCP_ECN_DEMAND_CWR;
+}
+
+/*
+ * Receiver side, as in DCTCP: echo ECE on exactly the ACKs that cover CE
+ * marked data rather than holding it until CWR, so the sender sees how
+ * much of each window was marked.
+ */
+static void relentless_ece_ack_update(struct sock *sk, enum tcp_ca_event event)
+{
+	struct relentless *ca = inet_csk_ca(sk);
+	u32 new_ce_state = event == CA_EVENT_ECN_IS_CE;
+
+	if (ca->ce_state != new_ce_state) {
+		/* Send any delayed ACK for the prior state first */
+		if (inet_csk(sk)->icsk_ack.pending & ICSK_ACK_TIMER) {
+			relentless_ece_ack_cwr(sk, ca->ce_state);
+			__tcp_send_ack(sk, ca->prior_rcv_nxt);
+		}
+		inet_csk(sk)->icsk_ack.pending |= ICSK_ACK_NOW;
+	}
+
+	ca->prior_rcv_nxt = tcp_sk(sk)->rcv_nxt;
+	ca->ce_state = new_ce_state;
+	relentless_ece_ack_cwr(sk, new_ce_state);
+}
+
+static void relentless_in_ack_event(struct sock *sk, u32 flags)
+{
+	struct relentless *ca = inet_csk_ca(sk);
+
+	ca->ece = !!(flags & CA_ACK_ECE);
+}
+
+/*
+ * Set ssthresh to saved cwnd minus the segments RACK or dupack counting
+ * marked lost since, which is what the lossy round actually delivered.
+ * tp->lost ignores TLP probes and spurious retransmits, unlike
+ * total_retrans.  PRR has just set cwnd to the ssthresh taken on entry, so
+ * pull it and rtt_cwnd down to cover losses found later in the episode.
+ */
+static void relentless_complete_cwr(struct sock *sk)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct relentless *ca = inet_csk_ca(sk);
+
+	relentless_snd_cwnd_set(tp, relentless_end_recovery(ca, relentless_snd_cwnd(tp), tp->lost,
+							    &tp->snd_ssthresh));
+	trace_relentless_complete_cwr(sk, minmax_get(&ca->rtt_min),
+				      ca->rtt_thresh, 0, ca->rtt_cwnd);
+	relentless_stat_inc(sk, RELENTLESS_STAT_CWR_COMPLETIONS);
 }
 
 static void relentless_event(struct sock *sk, enum tcp_ca_event event)
@@ -131,82 +959,622 @@ static void relentless_event(struct sock *sk, enum tcp_ca_event event)
 	struct relentless *ca = inet_csk_ca(sk);
 
 	switch (event) {
+	case CA_EVENT_ECN_IS_CE:
+	case CA_EVENT_ECN_NO_CE:
+		if (relentless_ecn_ok(sk))
+			relentless_ece_ack_update(sk, event);
+		break;
+
+	case CA_EVENT_TX_START:
+		relentless_idle_restart(sk);
+		break;
+
 	case CA_EVENT_COMPLETE_CWR:
-		/* set ssthresh to saved cwnd minus net losses */
-		tp->snd_ssthresh = ca->cwndnlosses - tp->total_retrans;
-	
+		relentless_complete_cwr(sk);
+		break;
+
+	case CA_EVENT_LOSS:
+		/*
+		 * RTO, and tcp_enter_loss() is reducing ssthresh: on the first
+		 * timeout, after progress in Loss, or once recovery's high_seq
+		 * was passed.  Leaving Open, prior_cwnd was just taken and the
+		 * snapshot is made here rather than in set_state.
+		 */
+		tp->snd_ssthresh = relentless_loss_ssthresh(ca, inet_csk(sk)->icsk_ca_state,
+							    tp->prior_cwnd, tp->lost - tp->lost_out,
+							    tcp_is_cwnd_limited(sk));
+		trace_relentless_loss(sk, tp->packets_out, ca->rtt_cwnd);
+		relentless_stat_inc(sk, RELENTLESS_STAT_RTO_RESETS);
+		break;
+
+	default:
+		break;
+	}
+}
+
+/*
+ * Called before icsk_ca_state changes.  Entering CWR, recovery or loss from
+ * Open snapshots the window the losses are counted against, an RTO rebuilds
+ * from the one packet the stack left, and returning to Open adopts whatever
+ * cwnd recovery or undo produced so rtt_cwnd cannot drift from it.
+ *
+ * tcp_end_cwnd_reduction() returns early for cong_control ops, so they never
+ * see CA_EVENT_COMPLETE_CWR: relentless_rate applies the loss rule here when
+ * a CWR or recovery episode that was not undone ends.
+ */
+static void relentless_set_state(struct sock *sk, u8 new_state)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct relentless *ca = inet_csk_ca(sk);
+	u8 old_state = inet_csk(sk)->icsk_ca_state;
+
+	if (relentless_enter_reduction(old_state, new_state)) {
+		if (new_state != TCP_CA_Loss)
+			relentless_snapshot(ca, tp->prior_cwnd, tp->lost - tp->lost_out,
+					    tcp_is_cwnd_limited(sk));
+		ca->undone = 0;
+	}
+
+	switch (new_state) {
+	case TCP_CA_Loss:
+		relentless_restart(ca, relentless_snd_cwnd(tp));
+		relentless_round_start(sk);
+		break;
+
+	case TCP_CA_Open:
+		if ((old_state == TCP_CA_CWR || old_state == TCP_CA_Recovery) &&
+		    !ca->undone && inet_csk(sk)->icsk_ca_ops->cong_control)
+			relentless_complete_cwr(sk);
+		if (old_state >= TCP_CA_CWR) {
+			relentless_adopt_cwnd(ca, relentless_snd_cwnd(tp));
+			relentless_round_start(sk);
+		}
+		break;
+
 	default:
 		break;
 	}
 }
 
-static void relentless_pkts_acked(struct sock *sk, u32 num_acked, s32 rtt)
+/*
+ * Leave slowstart before the queue overflows, either when the ACK train of a
+ * round has lasted about half of rtt_min, or when the minimum RTT seen in a
+ * round is already above rtt_thresh.
+ */
+static void relentless_hystart_update(struct sock *sk, u32 rtt_min)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct relentless *ca = inet_csk_ca(sk);
+	bool found = false;
+
+	if (hystart_detect & HYSTART_ACK_TRAIN) {
+		u32 now = (u32)tp->tcp_mstamp;
+		u32 threshold = rtt_min;
+
+		/* Without pacing the whole window arrives in rtt_min / 2 */
+		if (sk->sk_pacing_status == SK_PACING_NONE)
+			threshold >>= 1;
+
+		if ((s32)(now - ca->last_ack) <= (s32)hystart_ack_delta_us) {
+			ca->last_ack = now;
+			if ((s32)(now - ca->round_start) > (s32)threshold)
+				found = true;
+		}
+	}
+
+	if ((hystart_detect & HYSTART_DELAY) &&
+	    ca->sample_cnt >= HYSTART_MIN_SAMPLES && ca->curr_rtt > ca->rtt_thresh)
+		found = true;
+
+	if (found) {
+		tp->snd_ssthresh = relentless_snd_cwnd(tp);
+		trace_relentless_exit_slow_start(sk, rtt_min, ca->rtt_thresh,
+						 ca->curr_rtt, ca->rtt_cwnd);
+		relentless_stat_inc(sk, RELENTLESS_STAT_SS_EXITS);
+	}
+}
+
+/*
+ * The min filter lets old minima expire, so the threshold follows the path
+ * after a route change or a shift in the baseline queue.
+ */
+static u32 relentless_update_rtt_min(struct sock *sk, u32 rtt)
+{
+	struct relentless *ca = inet_csk_ca(sk);
+	u32 win = READ_ONCE(relentless_params(sk)->rtt_min_win_sec) * HZ;
+	u32 prior_rtt_min = minmax_get(&ca->rtt_min);
+	u32 rtt_min = minmax_running_min(&ca->rtt_min, win, tcp_jiffies32, rtt);
+
+	if (rtt_min != prior_rtt_min)
+		ca->rtt_thresh = relentless_rtt_thresh(ca, rtt_min);
+	return rtt_min;
+}
+
+/* Apply a reduced rtt_cwnd, leaving slowstart if it takes cwnd below ssthresh */
+static void relentless_backoff(struct sock *sk, u32 rtt_min, u32 rtt)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct relentless *ca = inet_csk_ca(sk);
+
+	relentless_snd_cwnd_set(tp, relentless_fp_to_cwnd(ca->rtt_cwnd));
+	trace_relentless_backoff(sk, rtt_min, ca->rtt_thresh, rtt, ca->rtt_cwnd);
+	relentless_stat_inc(sk, RELENTLESS_STAT_BACKOFFS);
+
+	if (relentless_snd_cwnd(tp) < tp->snd_ssthresh) {
+		tp->snd_ssthresh = relentless_snd_cwnd(tp);
+		trace_relentless_exit_slow_start(sk, rtt_min, ca->rtt_thresh,
+						 rtt, ca->rtt_cwnd);
+		relentless_stat_inc(sk, RELENTLESS_STAT_SS_EXITS);
+	}
+}
+
+/*
+ * Proportional backoff.  Once per round, fold how far the round was above
+ * rtt_thresh (excess / cnt usecs, relative to the target queue of
+ * rtt_thresh - rtt_min), or with ECN the fraction of packets marked, into
+ * alpha the way DCTCP folds in its mark fraction.  A congested round then
+ * takes alpha / 2 off rtt_cwnd, so a queue just over target costs little
+ * and one far over it costs up to half the window.
+ */
+static void relentless_proportional(struct sock *sk, u32 rtt_min, bool ecn_ok,
+				    u64 excess, u64 cnt, bool congested)
+{
+	struct relentless *ca = inet_csk_ca(sk);
+	u64 target = ecn_ok ? 1 : max(ca->rtt_thresh - rtt_min, 1U);
+	u32 frac = 0;
+
+	/* Once per round, so the division is off the per-ACK path */
+	if (cnt)
+		frac = min_t(u64, div64_u64(excess << RELENTLESS_ALPHA_SHIFT, cnt * target),
+			     RELENTLESS_ALPHA_MAX);
+	ca->alpha = ca->alpha - (ca->alpha >> RELENTLESS_ALPHA_G) +
+		    (frac >> RELENTLESS_ALPHA_G);
+
+	if (congested) {
+		relentless_rtt_cwnd_add(ca, -(s64)(((u64)ca->rtt_cwnd * ca->alpha) >>
+						 (RELENTLESS_ALPHA_SHIFT + 1)));
+		relentless_backoff(sk, rtt_min, ca->sample_cnt ? ca->curr_rtt : 0);
+	}
+}
+
+static void relentless_sample_increase(struct sock *sk, u32 samples)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct relentless *ca = inet_csk_ca(sk);
+
+	if (!tcp_is_cwnd_limited(sk))
+		return;
+
+	relentless_sample_gain(ca, samples, READ_ONCE(sample_gain));
+	relentless_snd_cwnd_set(tp, relentless_fp_to_cwnd(ca->rtt_cwnd));
+}
+
+/*
+ * round_updates: the round's minimum RTT feeds the rtt_min filter and is
+ * the congestion decision (with ECN, any marked packet), and rtt_cwnd moves
+ * once by the packets the whole round acked.  The response no longer
+ * depends on how many ACKs GRO, LRO or stretch ACKs left us.
+ */
+static void relentless_round_update(struct sock *sk, bool ecn_ok)
+{
+	struct relentless *ca = inet_csk_ca(sk);
+	u32 rtt_min = minmax_get(&ca->rtt_min);
+	bool congested = false, signal = ecn_ok;
+
+	if (ca->sample_cnt) {
+		rtt_min = relentless_update_rtt_min(sk, ca->curr_rtt);
+		if (!ecn_ok && ca->rtts_observed >= ca->rtt_observations_needed) {
+			signal = true;
+			congested = ca->curr_rtt > ca->rtt_thresh;
+		}
+	}
+	if (ecn_ok)
+		congested = ca->round_marked > 0;
+
+	if (READ_ONCE(backoff_mode) == RELENTLESS_BACKOFF_PROPORTIONAL) {
+		if (ecn_ok)
+			relentless_proportional(sk, rtt_min, true, ca->round_marked,
+						ca->round_acked, congested);
+		else if (signal)
+			relentless_proportional(sk, rtt_min, false,
+						congested ? ca->curr_rtt - ca->rtt_thresh : 0,
+						1, congested);
+	} else if (congested) {
+		relentless_fixed_backoff(ca, ecn_ok ? ca->round_marked : ca->round_acked,
+					 READ_ONCE(backoff_gain));
+		relentless_backoff(sk, rtt_min, ca->sample_cnt ? ca->curr_rtt : 0);
+	}
+
+	if (signal && !congested && increase_law == RELENTLESS_INCREASE_SAMPLE)
+		relentless_sample_increase(sk, ca->round_acked);
+}
+
+/*
+ * Delay based backoff, driven by the per-ACK samples from tcp_clean_rtx_queue().
+ * sample->pkts_acked counts the packets newly delivered by this ACK (cumulatively
+ * or by SACK) and sample->rtt_us is the RTT measured on it, if any.
+ */
+static void relentless_pkts_acked(struct sock *sk, const struct ack_sample *sample)
 {
 	struct tcp_sock *tp = tcp_sk(sk);
 	struct relentless *ca = inet_csk_ca(sk);
-	u32 r;
+	u32 num_acked = sample->pkts_acked;
+	u32 r = 0, rtt_min = minmax_get(&ca->rtt_min);
+	bool per_round = READ_ONCE(round_updates);
+	bool ecn_ok = relentless_ecn_ok(sk);
+	bool proportional = READ_ONCE(backoff_mode) == RELENTLESS_BACKOFF_PROPORTIONAL;
+	bool signal = ecn_ok, congested = false;
+
+	if (!num_acked)
+		return;
+
+	if (sample->rtt_us > 0) {
+		r = (u32) sample->rtt_us;
+		relentless_rtt_sample(ca, r);
+
+		if (!per_round)
+			rtt_min = relentless_update_rtt_min(sk, r);
+		relentless_stat_hist(sk, qdelay_us, RELENTLESS_QDELAY_BUCKETS,
+				     r > rtt_min ? r - rtt_min : 0);
+
+		if (hystart_detect && tcp_in_slow_start(tp) &&
+		    relentless_snd_cwnd(tp) >= hystart_low_window)
+			relentless_hystart_update(sk, rtt_min);
+	}
+
+	if (ecn_ok) {
+		/* The bottleneck marks for us, no need to wait for samples */
+		congested = ca->ece;
+	} else if (relentless_delay_signal(ca, r)) {
+		/* Mimic DCTCP ECN marking threshhold of approximately 0.17*BDP */
+		signal = true;
+		congested = relentless_rtt_over(ca, r, READ_ONCE(rtt_filter_samples));
+	}
+
+	relentless_account(ca, num_acked, r, congested, ecn_ok);
+
+	if (!per_round && !proportional && congested) {
+		relentless_fixed_backoff(ca, num_acked, READ_ONCE(backoff_gain));
+		relentless_backoff(sk, rtt_min, r);
+	}
 
-	if (rtt <= 0)
+	if (!per_round && signal && !congested &&
+	    increase_law == RELENTLESS_INCREASE_SAMPLE)
+		relentless_sample_increase(sk, 1);
+
+	if (before(tp->snd_una, ca->round_end_seq))
 		return;
 
-	ca->rtts_observed++;
-	r = (u32) rtt;
+	relentless_stat_hist(sk, rtt_cwnd, RELENTLESS_CWND_BUCKETS,
+			     relentless_fp_to_cwnd(ca->rtt_cwnd));
+	relentless_tso_burst_update(sk);
+	relentless_dst_update(sk);
+	if (per_round)
+		relentless_round_update(sk, ecn_ok);
+	else if (proportional)
+		relentless_proportional(sk, rtt_min, ecn_ok,
+					ecn_ok ? ca->round_marked : ca->excess_sum,
+					ecn_ok ? ca->round_acked : ca->sample_cnt,
+					ca->round_marked > 0);
+	relentless_round_start(sk);
+}
+
+static size_t relentless_get_info(struct sock *sk, u32 ext, int *attr,
+				  union tcp_cc_info *info)
+{
+	const struct relentless *ca = inet_csk_ca(sk);
+	struct tcp_relentless_info *ri = (struct tcp_relentless_info *)info;
+
+	BUILD_BUG_ON(sizeof(*ri) > sizeof(*info));
+
+	/* inet_diag readers ask for it as vegas info, as for other delay based ccs */
+	if (ext & (1 << (INET_DIAG_VEGASINFO - 1))) {
+		ri->relentless_rtt_min = minmax_get(&ca->rtt_min);
+		ri->relentless_rtt_thresh = ca->rtt_thresh;
+		ri->relentless_rtt_cwnd = ca->rtt_cwnd;
+		ri->relentless_save_cwnd = ca->save_cwnd;
+		ri->relentless_rtts_observed = ca->rtts_observed;
+		ri->relentless_backoffs = ca->backoffs;
+		*attr = INET_DIAG_RELENTLESSINFO;
+		return sizeof(*ri);
+	}
+	return 0;
+}
+
+static void relentless_rate_init(struct sock *sk)
+{
+	relentless_init(sk);
+
+	/* Use the internal pacing timer if there is no fq qdisc */
+	cmpxchg(&sk->sk_pacing_status, SK_PACING_NONE, SK_PACING_NEEDED);
+}
 
-	if (rtt < ca->rtt_min) {
-		ca->rtt_min = r;
-		ca->rtt_thresh = r + (r * markthresh / RELENTLESS_MAX_MARK);
+/* Track the max delivery rate over the current and the previous round trip */
+static void relentless_update_bw(struct sock *sk, const struct rate_sample *rs)
+{
+	struct relentless *ca = inet_csk_ca(sk);
+	u64 delivered, floor;
+
+	if (ca->round_started) {
+		ca->round_started = 0;
+		ca->prior_bw = ca->bw;
+		ca->bw = 0;
 	}
 
-	if (ca->rtts_observed < slowstart_rtt_observations_needed)
+	/* the interval bound keeps floor * interval_us below in 64 bits */
+	if (rs->delivered < 0 || rs->interval_us <= 0 || rs->interval_us > U32_MAX)
 		return;
 
-	/* Mimic DCTCP ECN marking threshhold of approximately 0.17*BDP */
-	if (r > ca->rtt_thresh) {
-		ca->rtt_cwnd -= (num_acked << 6U);
-		ca->rtt_cwnd = max(ca->rtt_cwnd, (2U << 10U));
+	/*
+	 * The lowest rate that raises the filter.  App limited samples only
+	 * tell us the rate is at least this much, so they must also reach the
+	 * previous round's.  Most samples fall short, which the products show
+	 * without dividing; the rate itself is only computed when it counts.
+	 */
+	floor = (u64)ca->bw + 1;
+	if (rs->is_app_limited)
+		floor = max_t(u64, floor, ca->prior_bw);
+	delivered = (u64)rs->delivered << RELENTLESS_BW_SCALE;
+	if (floor > U32_MAX || delivered < floor * rs->interval_us)
+		return;
 
-		if (ca->debug)
-			pr_info_ratelimited("relentless backoff: rtt_min=%u, rtt_thresh=%u, rtt=%u, rtt_cwnd=%u, cwnd=%u, ssthresh=%u\n",
-				ca->rtt_min, ca->rtt_thresh, (u32)r, ca->rtt_cwnd, tp->snd_cwnd, tp->snd_ssthresh);
+	ca->bw = min_t(u64, div_u64(delivered, rs->interval_us), U32_MAX);
+}
 
-		tp->snd_cwnd = (ca->rtt_cwnd >> 10U);
+/*
+ * Replaces the stack's PRR and cong_avoid calls when relentless_rate is
+ * selected.  During recovery cwnd is reduced by exactly the newly detected
+ * losses, otherwise the usual Relentless cong_avoid rule applies, with an
+ * app limited rate sample counting as not cwnd limited.  Either way, the
+ * window is paced out at the measured delivery rate.
+ */
+static void relentless_cong_control(RELENTLESS_CONG_CONTROL_ARGS)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct relentless *ca = inet_csk_ca(sk);
 
-		if (tp->snd_cwnd < tp->snd_ssthresh) {
-			tp->snd_ssthresh = tp->snd_cwnd;
+	relentless_update_bw(sk, rs);
 
-			if (ca->debug)
-				pr_info_ratelimited("relentless exit slow start: rtt_min=%u, rtt_thresh=%u, rtt=%u, rtt_cwnd=%u, cwnd=%u, ssthresh=%u\n",
-					ca->rtt_min, ca->rtt_thresh, (u32)r, ca->rtt_cwnd, tp->snd_cwnd, tp->snd_ssthresh);
+	if (tcp_in_cwnd_reduction(sk)) {
+		if (rs->losses > 0) {
+			relentless_rtt_cwnd_add(ca, -((s64)rs->losses << RELENTLESS_CWND_SHIFT));
+			relentless_snd_cwnd_set(tp, max_t(s32, relentless_snd_cwnd(tp) - rs->losses, 2));
+			trace_relentless_loss(sk, rs->losses, ca->rtt_cwnd);
 		}
 	} else {
-		ca->rtt_cwnd += (1 << 10U);
-		tp->snd_cwnd = (ca->rtt_cwnd >> 10U);
+		relentless_update_cwnd(sk, rs->acked_sacked,
+				       tcp_is_cwnd_limited(sk) && !rs->is_app_limited);
 	}
+	relentless_snd_cwnd_set(tp, min(relentless_snd_cwnd(tp), tp->snd_cwnd_clamp));
+
+	relentless_set_pacing_rate(sk, tcp_in_slow_start(tp) ?
+				   pacing_ss_gain : pacing_gain);
 }
 
 static struct tcp_congestion_ops tcp_relentless = {
 	.init		= relentless_init,
+	.release	= relentless_release,
 	.ssthresh	= relentless_ssthresh,
 	.cong_avoid	= relentless_cong_avoid,
 	.cwnd_event	= relentless_event,
-	.pkts_acked 	= relentless_pkts_acked,
+	.set_state	= relentless_set_state,
+	.in_ack_event	= relentless_in_ack_event,
+	.undo_cwnd	= relentless_undo_cwnd,
+	.pkts_acked	= relentless_pkts_acked,
+	.min_tso_segs	= relentless_min_tso_segs,
+	.sndbuf_expand	= relentless_sndbuf_expand,
+	.get_info	= relentless_get_info,
 	.owner		= THIS_MODULE,
 	.name		= "relentless",
 };
 
+/* Same algorithm, but cwnd and pacing rate are set from rate samples */
+static struct tcp_congestion_ops tcp_relentless_rate = {
+	.init		= relentless_rate_init,
+	.release	= relentless_release,
+	.ssthresh	= relentless_ssthresh,
+	.cong_control	= relentless_cong_control,
+	.cwnd_event	= relentless_event,
+	.set_state	= relentless_set_state,
+	.in_ack_event	= relentless_in_ack_event,
+	.undo_cwnd	= relentless_undo_cwnd,
+	.pkts_acked	= relentless_pkts_acked,
+	.min_tso_segs	= relentless_min_tso_segs,
+	.sndbuf_expand	= relentless_sndbuf_expand,
+	.get_info	= relentless_get_info,
+	.owner		= THIS_MODULE,
+	.name		= "relentless_rate",
+};
+
+static struct ctl_table relentless_sysctl_table[] = {
+	{
+		.procname	= "tcp_relentless_markthresh",
+		.data		= &relentless_defaults.markthresh,
+		.maxlen		= sizeof(unsigned int),
+		.mode		= 0644,
+		.proc_handler	= proc_douintvec_minmax,
+		.extra2		= &relentless_u16_max,
+	},
+	{
+		.procname	= "tcp_relentless_slowstart_rtt_observations_needed",
+		.data		= &relentless_defaults.slowstart_rtt_observations_needed,
+		.maxlen		= sizeof(unsigned int),
+		.mode		= 0644,
+		.proc_handler	= proc_douintvec_minmax,
+		.extra2		= &relentless_u16_max,
+	},
+	{
+		.procname	= "tcp_relentless_rtt_min_win_sec",
+		.data		= &relentless_defaults.rtt_min_win_sec,
+		.maxlen		= sizeof(unsigned int),
+		.mode		= 0644,
+		.proc_handler	= proc_douintvec,
+	},
+	{
+		.procname	= "tcp_relentless_qdelay_floor_us",
+		.data		= &relentless_defaults.qdelay_floor_us,
+		.maxlen		= sizeof(unsigned int),
+		.mode		= 0644,
+		.proc_handler	= proc_douintvec_minmax,
+		.extra2		= &relentless_u16_max,
+	},
+	{
+		.procname	= "tcp_relentless_qdelay_target_us",
+		.data		= &relentless_defaults.qdelay_target_us,
+		.maxlen		= sizeof(unsigned int),
+		.mode		= 0644,
+		.proc_handler	= proc_douintvec_minmax,
+		.extra2		= &relentless_u16_max,
+	},
+	RELENTLESS_SYSCTL_END
+};
+
+static void relentless_stats_show_hist(struct seq_file *seq, const char *name,
+				       const unsigned long *hist, int buckets)
+{
+	int i;
+
+	seq_puts(seq, name);
+	for (i = 0; i < buckets; i++)
+		seq_printf(seq, " %lu", hist[i]);
+	seq_putc(seq, '\n');
+}
+
+/* One "name value" line per counter, one "name bucket0 bucket1 ..." per histogram */
+static int relentless_stats_show(struct seq_file *seq, void *v)
+{
+	const struct relentless_net *rn = net_generic(seq_file_single_net(seq), relentless_net_id);
+	struct relentless_stats sum = { };
+	const struct relentless_stats *s;
+	int i, cpu;
+
+	for_each_possible_cpu(cpu) {
+		s = per_cpu_ptr(rn->stats, cpu);
+		for (i = 0; i < RELENTLESS_STAT_MAX; i++)
+			sum.cnt[i] += s->cnt[i];
+		for (i = 0; i < RELENTLESS_CWND_BUCKETS; i++)
+			sum.rtt_cwnd[i] += s->rtt_cwnd[i];
+		for (i = 0; i < RELENTLESS_QDELAY_BUCKETS; i++)
+			sum.qdelay_us[i] += s->qdelay_us[i];
+	}
+
+	for (i = 0; i < RELENTLESS_STAT_MAX; i++)
+		seq_printf(seq, "%s %lu\n", relentless_stat_names[i], sum.cnt[i]);
+	relentless_stats_show_hist(seq, "rtt_cwnd_log2", sum.rtt_cwnd,
+				   RELENTLESS_CWND_BUCKETS);
+	relentless_stats_show_hist(seq, "qdelay_us_log2", sum.qdelay_us,
+				   RELENTLESS_QDELAY_BUCKETS);
+	return 0;
+}
+
+static int __net_init relentless_net_init(struct net *net)
+{
+	struct relentless_net *rn = net_generic(net, relentless_net_id);
+	struct ctl_table *table = relentless_sysctl_table;
+
+	rn->params = &relentless_defaults;
+	if (!net_eq(net, &init_net)) {
+		rn->ns_params = relentless_defaults;
+		rn->params = &rn->ns_params;
+
+		table = kmemdup(table, sizeof(relentless_sysctl_table), GFP_KERNEL);
+		if (!table)
+			return -ENOMEM;
+		table[0].data = &rn->ns_params.markthresh;
+		table[1].data = &rn->ns_params.slowstart_rtt_observations_needed;
+		table[2].data = &rn->ns_params.rtt_min_win_sec;
+		table[3].data = &rn->ns_params.qdelay_floor_us;
+		table[4].data = &rn->ns_params.qdelay_target_us;
+	}
+
+	rn->sysctl_header = register_net_sysctl_sz(net, "net/ipv4", table,
+						   ARRAY_SIZE(relentless_sysctl_table));
+	if (!rn->sysctl_header)
+		goto err_table;
+
+	rn->stats = alloc_percpu(struct relentless_stats);
+	if (!rn->stats)
+		goto err_sysctl;
+
+	if (!proc_create_net_single("relentless", 0444, net->proc_net,
+				    relentless_stats_show, NULL))
+		goto err_stats;
+
+	return 0;
+
+err_stats:
+	free_percpu(rn->stats);
+err_sysctl:
+	unregister_net_sysctl_table(rn->sysctl_header);
+err_table:
+	if (table != relentless_sysctl_table)
+		kfree(table);
+	return -ENOMEM;
+}
+
+static void __net_exit relentless_net_exit(struct net *net)
+{
+	struct relentless_net *rn = net_generic(net, relentless_net_id);
+	const struct ctl_table *table = rn->sysctl_header->ctl_table_arg;
+
+	remove_proc_entry("relentless", net->proc_net);
+	free_percpu(rn->stats);
+	unregister_net_sysctl_table(rn->sysctl_header);
+	if (table != relentless_sysctl_table)
+		kfree(table);
+	relentless_dst_flush(net);
+}
+
+static struct pernet_operations relentless_net_ops = {
+	.init	= relentless_net_init,
+	.exit	= relentless_net_exit,
+	.id	= &relentless_net_id,
+	.size	= sizeof(struct relentless_net),
+};
+
 static int __init relentless_register(void)
 {
-	return tcp_register_congestion_control(&tcp_relentless);
+	int ret;
+
+	BUILD_BUG_ON(sizeof(struct relentless) > ICSK_CA_PRIV_SIZE);
+
+	if (ecn) {
+		tcp_relentless.flags |= TCP_CONG_NEEDS_ECN;
+		tcp_relentless_rate.flags |= TCP_CONG_NEEDS_ECN;
+	}
+
+	ret = register_pernet_subsys(&relentless_net_ops);
+	if (ret)
+		return ret;
+
+	ret = tcp_register_congestion_control(&tcp_relentless);
+	if (ret)
+		goto err_pernet;
+
+	ret = tcp_register_congestion_control(&tcp_relentless_rate);
+	if (ret)
+		goto err_relentless;
+
+	return 0;
+
+err_relentless:
+	tcp_unregister_congestion_control(&tcp_relentless);
+err_pernet:
+	unregister_pernet_subsys(&relentless_net_ops);
+	return ret;
 }
 
 static void __exit relentless_unregister(void)
 {
+	tcp_unregister_congestion_control(&tcp_relentless_rate);
 	tcp_unregister_congestion_control(&tcp_relentless);
+	unregister_pernet_subsys(&relentless_net_ops);
 }
 
 module_init(relentless_register);
 module_exit(relentless_unregister);
 
+MODULE_ALIAS("tcp_relentless_rate");
 MODULE_AUTHOR("Matt Mathis");
 MODULE_LICENSE("GPL");
 MODULE_DESCRIPTION("Relentless TCP");
@@ -0,0 +1,39 @@
+/*
+ * Relentless TCP, definitions shared with userspace.
+ */
+#ifndef _TCP_RELENTLESS_H
+#define _TCP_RELENTLESS_H
+
+#include <linux/types.h>
+
+/*
+ * Netlink attribute carrying struct tcp_relentless_info in inet_diag dumps.
+ * The module is out of tree, so it uses a type above the upstream
+ * INET_DIAG_* range.  Parsers that only know the upstream types, ss among
+ * them, drop it: only getsockopt(TCP_CC_INFO), which returns the same
+ * structure, and netlink readers that look for this type, such as
+ * sim/relentless_diag, see it.  It is sent when the dump requests
+ * INET_DIAG_VEGASINFO.
+ */
+#define INET_DIAG_RELENTLESSINFO	0x100
+
+/*
+ * Must fit in union tcp_cc_info, which is five u32s, so the counters are
+ * 16 bits and saturate.  That leaves no room for cwndnlosses, the saved
+ * window plus the socket's tp->lost when it was taken; tp->lost is not in
+ * tcp_info either, so it cannot be recovered from userspace.  Its result,
+ * the ssthresh set when recovery ends, is tcpi_snd_ssthresh.
+ *
+ * rtt_cwnd is the only fixed point field, packets with 10 fractional bits
+ * (RELENTLESS_CWND_SHIFT); shift it right by 10 for whole packets.
+ */
+struct tcp_relentless_info {
+	__u32	relentless_rtt_min;	/* windowed min RTT, usecs */
+	__u32	relentless_rtt_thresh;	/* backoff threshold, usecs */
+	__u32	relentless_rtt_cwnd;	/* controller cwnd, packets << 10 */
+	__u32	relentless_save_cwnd;	/* cwnd before disorder/recovery, packets */
+	__u16	relentless_rtts_observed; /* RTT samples taken */
+	__u16	relentless_backoffs;	/* ACKs that backed off on delay */
+};
+
+#endif /* _TCP_RELENTLESS_H */
@@ -0,0 +1,68 @@
+/*
+ * Kernel API differences between the releases the module builds on, Linux
+ * 5.4 and newer, so one source tree behaves the same across them.  Every
+ * difference is resolved here, on LINUX_VERSION_CODE, and tcp_relentless.c
+ * is written against the newest API.
+ *
+ * pkts_acked has taken a struct ack_sample since 4.7 and undo_cwnd is
+ * mandatory since 4.13, so neither needs mapping in this range.
+ */
+#ifndef _TCP_RELENTLESS_COMPAT_H
+#define _TCP_RELENTLESS_COMPAT_H
+
+#include <linux/version.h>
+#include <net/tcp.h>
+
+#if LINUX_VERSION_CODE < KERNEL_VERSION(5, 4, 0)
+#error "tcp_relentless needs Linux 5.4 or newer"
+#endif
+
+/*
+ * The snd_cwnd accessors came in 5.19, and were backported to some 5.4.y,
+ * 5.10.y and 5.15.y stable releases but not others, so the version cannot
+ * tell whether <net/tcp.h> has them.  Wrap them under private names; the
+ * field itself is still snd_cwnd everywhere.
+ */
+static inline u32 relentless_snd_cwnd(const struct tcp_sock *tp)
+{
+#if LINUX_VERSION_CODE < KERNEL_VERSION(5, 19, 0)
+	return tp->snd_cwnd;
+#else
+	return tcp_snd_cwnd(tp);
+#endif
+}
+
+static inline void relentless_snd_cwnd_set(struct tcp_sock *tp, u32 val)
+{
+#if LINUX_VERSION_CODE < KERNEL_VERSION(5, 19, 0)
+	WARN_ON_ONCE((int)val <= 0);
+	tp->snd_cwnd = val;
+#else
+	tcp_snd_cwnd_set(tp, val);
+#endif
+}
+
+/* cong_control is also passed the ACK's sequence number and flags since 6.10 */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 10, 0)
+#define RELENTLESS_CONG_CONTROL_ARGS \
+	struct sock *sk, u32 ack, int flag, const struct rate_sample *rs
+#else
+#define RELENTLESS_CONG_CONTROL_ARGS \
+	struct sock *sk, const struct rate_sample *rs
+#endif
+
+/*
+ * Before 6.6 register_net_sysctl() walks the table up to an empty entry.
+ * Since then it is a macro taking ARRAY_SIZE() of an array, so a kmemdup'd
+ * table is registered with register_net_sysctl_sz() and its size, and newer
+ * kernels reject the empty entry.
+ */
+#if LINUX_VERSION_CODE < KERNEL_VERSION(6, 6, 0)
+#define RELENTLESS_SYSCTL_END	{ }
+#define register_net_sysctl_sz(net, path, table, size) \
+	register_net_sysctl(net, path, table)
+#else
+#define RELENTLESS_SYSCTL_END
+#endif
+
+#endif /* _TCP_RELENTLESS_COMPAT_H */
@@ -0,0 +1,331 @@
+/*
+ * Relentless TCP, the controller state and arithmetic shared by the kernel
+ * module (tcp_relentless.c) and the BPF struct_ops version
+ * (tcp_relentless.bpf.c).
+ *
+ * Nothing here touches the socket or reads a tunable: callers pass in the
+ * tcp_sock counters and parameter values they use, so the same code builds
+ * against the kernel headers and against vmlinux.h.  The includer provides
+ * u8/u16/u32/u64/s32/s64, bool, min(), max(), U16_MAX, U32_MAX, struct minmax
+ * and the TCP_CA_* states.
+ */
+#ifndef _TCP_RELENTLESS_CORE_H
+#define _TCP_RELENTLESS_CORE_H
+
+#define RELENTLESS_MARK_SHIFT 10U
+#define RELENTLESS_MAX_MARK (1U << RELENTLESS_MARK_SHIFT)
+
+/*
+ * rtt_cwnd is cwnd in 1/1024ths of a packet.  It stays in a u32, which caps
+ * the window at 4M packets (about 1.7 s at 400 Gbit/s with 1500 byte
+ * packets); all updates saturate rather than wrap.
+ */
+#define RELENTLESS_CWND_SHIFT 10U
+#define RELENTLESS_CWND_ONE (1U << RELENTLESS_CWND_SHIFT)
+#define RELENTLESS_CWND_MIN (2U << RELENTLESS_CWND_SHIFT)
+#define RELENTLESS_CWND_MAX (U32_MAX >> RELENTLESS_CWND_SHIFT)
+
+/* Congestion avoidance increase laws, see increase_law */
+enum relentless_increase {
+	RELENTLESS_INCREASE_SAMPLE = 0,	/* +1 per RTT sample below rtt_thresh */
+	RELENTLESS_INCREASE_RENO = 1,	/* +1 per RTT */
+	RELENTLESS_INCREASE_SCALABLE = 2,	/* +1 per 100 ACKed, as tcp_scalable */
+};
+
+#define RELENTLESS_SCALABLE_AI_CNT 100U
+
+/* Longest run of RTT samples over rtt_thresh rtt_over counts */
+#define RELENTLESS_RTT_FILTER_MAX 7U
+
+/*
+ * Relentless structure, in icsk_ca_priv.  Fields used on every ACK come
+ * first, the rate, HyStart and receiver side state follows.  That is only
+ * an ordering: icsk_ca_priv is not cache line aligned within the socket,
+ * and the every ACK group runs to offset 72, rtt_min ending at 64.
+ *
+ * The structure fills icsk_ca_priv exactly, 104 of 104 bytes, which
+ * BUILD_BUG_ON in the module and _Static_assert in the BPF version check.
+ * A new field has to take the space of an existing one, for example by
+ * replacing the per socket parameter copies (markthresh and the qdelay
+ * bounds) with a u8 index into a table of parameter profiles.
+ */
+struct relentless {
+	/* every ACK */
+	u32 rtt_cwnd;      /* cwnd scaled by 1024 */
+	u32 rtt_thresh;
+	u32 round_end_seq; /* snd_nxt at the start of the round */
+	u32 curr_rtt;      /* min RTT of the current round */
+	u32 round_acked;   /* packets acked in the current round */
+	u32 round_marked;  /* ditto, by ACKs carrying a congestion signal */
+	u32 excess_sum;    /* usecs over rtt_thresh, summed this round */
+	u16 rtts_observed; /* saturates, only compared to the limit below */
+	u16 rtt_observations_needed;
+	u16 sample_cnt;    /* RTT samples in the current round */
+	u16 backoffs;      /* ACK samples that backed off, saturates */
+	u16 markthresh;    /* per socket copy of the tuning parameter */
+	u8  ece:1,         /* sender: the ACK being processed echoes CE */
+	    round_started:1, /* a new round began, for the bw filter */
+	    ce_state:1,    /* receiver: CE seen on the last data packet */
+	    dst_joined:1,  /* counted in a destination cache entry */
+	    rtt_over:3,    /* consecutive RTT samples over rtt_thresh, saturates */
+	    undone:1;      /* the current reduction was undone */
+	u8  dst_flows;     /* flows sharing a contended entry, else 1 */
+	struct minmax rtt_min; /* windowed min of RTT samples, in usecs */
+	u32 save_cwnd;     /* saved cwnd from before disorder or recovery */
+	u32 cwndnlosses;   /* ditto plus total losses todate */
+
+	/* relentless_rate, slowstart, once per round, receiver */
+	u32 bw;            /* max delivery rate this round, BW_UNIT scaled */
+	u32 prior_bw;      /* ditto, previous round */
+	u32 round_start;   /* tcp_mstamp at the start of the round */
+	u32 last_ack;      /* HyStart: tcp_mstamp of the last ACK of the train */
+	u32 prior_rcv_nxt; /* receiver: rcv_nxt when ce_state was updated */
+	u16 alpha;         /* proportional: smoothed excess over target, /1024 */
+	u16 dst_cwnd;      /* window added to the destination cache entry */
+	u16 dst_backoffs;  /* backoffs when the entry was last updated */
+	u16 qdelay_floor_us;  /* per socket copies of the tuning parameters, */
+	u16 qdelay_target_us; /* bounds of rtt_thresh - rtt_min, 0 for none */
+	u16 tso_burst;     /* segments per TSO burst at the pacing rate, see below */
+};
+
+static inline u32 relentless_cwnd_to_fp(u32 cwnd)
+{
+	return min(cwnd, RELENTLESS_CWND_MAX) << RELENTLESS_CWND_SHIFT;
+}
+
+static inline u32 relentless_fp_to_cwnd(u32 rtt_cwnd)
+{
+	return rtt_cwnd >> RELENTLESS_CWND_SHIFT;
+}
+
+/* Move rtt_cwnd by delta 1/1024 packets, within [2 packets, CWND_MAX] */
+static inline void relentless_rtt_cwnd_add(struct relentless *ca, s64 delta)
+{
+	s64 rtt_cwnd = (s64)ca->rtt_cwnd + delta;
+
+	if (rtt_cwnd < RELENTLESS_CWND_MIN)
+		rtt_cwnd = RELENTLESS_CWND_MIN;
+	else if (rtt_cwnd > U32_MAX)
+		rtt_cwnd = U32_MAX;
+	ca->rtt_cwnd = rtt_cwnd;
+}
+
+/*
+ * rtt_min * (1 + markthresh / 1024), with the product in 64 bits.  The
+ * queueing delay this allows is raised to qdelay_floor_us, so host jitter
+ * on short paths is not taken for congestion, and then capped at
+ * qdelay_target_us, so long paths hold no more queue than that.
+ */
+static inline u32 relentless_rtt_thresh(const struct relentless *ca, u32 rtt_min)
+{
+	u64 qdelay = ((u64)rtt_min * ca->markthresh) >> RELENTLESS_MARK_SHIFT;
+	u64 thresh;
+
+	if (qdelay < ca->qdelay_floor_us)
+		qdelay = ca->qdelay_floor_us;
+	if (ca->qdelay_target_us && qdelay > ca->qdelay_target_us)
+		qdelay = ca->qdelay_target_us;
+	thresh = rtt_min + qdelay;
+	return thresh > U32_MAX ? U32_MAX : thresh;
+}
+
+static inline u32 relentless_add_sat(u32 a, u32 b)
+{
+	return a + b < a ? U32_MAX : a + b;
+}
+
+/* Clear the per-round counters for a round ending when snd_nxt is acked */
+static inline void relentless_round_reset(struct relentless *ca, u32 snd_nxt,
+					  u32 now_us)
+{
+	ca->round_end_seq = snd_nxt;
+	ca->round_start = ca->last_ack = now_us;
+	ca->curr_rtt = ~0U;
+	ca->sample_cnt = 0;
+	ca->round_acked = 0;
+	ca->round_marked = 0;
+	ca->excess_sum = 0;
+	ca->round_started = 1;
+}
+
+static inline void relentless_rtt_sample(struct relentless *ca, u32 rtt)
+{
+	if (ca->rtts_observed < U16_MAX)
+		ca->rtts_observed++;
+	ca->curr_rtt = min(ca->curr_rtt, rtt);
+	if (ca->sample_cnt < U16_MAX)
+		ca->sample_cnt++;
+}
+
+/* rtt_min is only trusted as a baseline once enough samples have been seen */
+static inline bool relentless_delay_signal(const struct relentless *ca, u32 rtt)
+{
+	return rtt && ca->rtts_observed >= ca->rtt_observations_needed;
+}
+
+/*
+ * True when this RTT sample and the n - 1 before it were all over
+ * rtt_thresh, that is when the min of the last n samples is.  A single
+ * sample inflated by a delayed ACK, interrupt coalescing or GRO does not
+ * count as congestion once n > 1.
+ */
+static inline bool relentless_rtt_over(struct relentless *ca, u32 rtt, u32 n)
+{
+	if (rtt <= ca->rtt_thresh) {
+		ca->rtt_over = 0;
+		return false;
+	}
+	if (ca->rtt_over < RELENTLESS_RTT_FILTER_MAX)
+		ca->rtt_over++;
+	return ca->rtt_over >= min(max(n, 1U), RELENTLESS_RTT_FILTER_MAX);
+}
+
+/* Count packets acked this round, and those acked by congested ACKs */
+static inline void relentless_account(struct relentless *ca, u32 acked, u32 rtt,
+				      bool congested, bool ecn_ok)
+{
+	ca->round_acked = relentless_add_sat(ca->round_acked, acked);
+	if (congested) {
+		if (ca->backoffs < U16_MAX)
+			ca->backoffs++;
+		ca->round_marked = relentless_add_sat(ca->round_marked, acked);
+		if (!ecn_ok)
+			ca->excess_sum = relentless_add_sat(ca->excess_sum,
+							    rtt - ca->rtt_thresh);
+	}
+}
+
+/*
+ * The Relentless loss rule.  The window is saved together with the
+ * socket's lost segment count (tp->lost) before a recovery episode, and
+ * ssthresh afterwards is the saved window less everything lost since.
+ * Only a window the flow filled shows what the network carries, so while
+ * rwnd or application limited the saved window can only come down.
+ */
+static inline void relentless_snapshot(struct relentless *ca, u32 cwnd, u32 lost,
+				       bool cwnd_limited)
+{
+	if (!cwnd_limited && ca->save_cwnd)
+		cwnd = min(cwnd, ca->save_cwnd);
+	ca->save_cwnd = cwnd;
+	ca->cwndnlosses = cwnd + lost;
+}
+
+/*
+ * The window cong_avoid sees in Open is what the losses of the next
+ * episode are counted against.  cong_avoid also runs in Loss, which must
+ * not overwrite the snapshot.
+ */
+static inline void relentless_open_snapshot(struct relentless *ca, u8 ca_state,
+					    u32 cwnd, u32 lost, bool cwnd_limited)
+{
+	if (ca_state == TCP_CA_Open)
+		relentless_snapshot(ca, cwnd, lost, cwnd_limited);
+}
+
+/*
+ * Entering CWR or recovery from Open or Disorder, prior_cwnd was just set
+ * by tcp_init_cwnd_reduction() and is snapshotted in set_state.  An RTO
+ * takes it at CA_EVENT_LOSS instead, before everything is marked lost.
+ */
+static inline bool relentless_enter_reduction(u8 old_state, u8 new_state)
+{
+	return new_state >= TCP_CA_CWR && old_state < TCP_CA_CWR;
+}
+
+/*
+ * CA_EVENT_LOSS, tcp_enter_loss() is reducing ssthresh: snapshot
+ * prior_cwnd if the episode starts here, and return the ssthresh to set.
+ * Everything outstanding is marked lost before ssthresh is asked for, which
+ * then comes out as 2.  The real losses are unknown, so slowstart back to
+ * half the window saved before the episode.
+ */
+static inline u32 relentless_loss_ssthresh(struct relentless *ca, u8 ca_state,
+					   u32 prior_cwnd, u32 lost,
+					   bool cwnd_limited)
+{
+	if (ca_state < TCP_CA_CWR)
+		relentless_snapshot(ca, prior_cwnd, lost, cwnd_limited);
+	return max(ca->save_cwnd >> 1, 2U);
+}
+
+static inline u32 relentless_recovery_ssthresh(const struct relentless *ca, u32 lost)
+{
+	s32 ssthresh = ca->cwndnlosses - lost;
+
+	return ssthresh > 2 ? ssthresh : 2;
+}
+
+/*
+ * The loss rule when CWR or recovery completes: set ssthresh from the
+ * snapshot and pull cwnd, and rtt_cwnd with it, down to it.  Returns cwnd.
+ */
+static inline u32 relentless_end_recovery(struct relentless *ca, u32 cwnd, u32 lost,
+					  u32 *ssthresh)
+{
+	*ssthresh = relentless_recovery_ssthresh(ca, lost);
+	cwnd = min(cwnd, *ssthresh);
+	ca->rtt_cwnd = min(ca->rtt_cwnd, relentless_cwnd_to_fp(cwnd));
+	return cwnd;
+}
+
+/*
+ * ssthresh on entering recovery.  Only the segments already marked lost
+ * come off, so PRR paces inflight down by the losses rather than
+ * rebuilding it back up to the old cwnd.
+ */
+static inline u32 relentless_cwnd_ssthresh(u32 cwnd, u32 lost_out)
+{
+	s32 ssthresh = cwnd - lost_out;
+
+	return ssthresh > 2 ? ssthresh : 2;
+}
+
+/* The w of tcp_cong_avoid_ai() for the increase law, shared by flows */
+static inline u32 relentless_ai_cnt(u32 law, u32 cwnd, u32 flows)
+{
+	if (law == RELENTLESS_INCREASE_SCALABLE)
+		cwnd = min(cwnd, RELENTLESS_SCALABLE_AI_CNT);
+	return cwnd * flows;
+}
+
+/* Fixed backoff, gain / 1024 packets off rtt_cwnd per packet acked */
+static inline void relentless_fixed_backoff(struct relentless *ca, u32 acked, u32 gain)
+{
+	relentless_rtt_cwnd_add(ca, -(s64)acked * gain);
+}
+
+/* Sample law increase, gain / 1024 packets onto rtt_cwnd per sample */
+static inline void relentless_sample_gain(struct relentless *ca, u32 samples, u32 gain)
+{
+	relentless_rtt_cwnd_add(ca, (s64)samples * gain);
+}
+
+/* The cwnd recovery or undo left becomes rtt_cwnd on the way back to Open */
+static inline void relentless_adopt_cwnd(struct relentless *ca, u32 cwnd)
+{
+	ca->rtt_cwnd = max(relentless_cwnd_to_fp(cwnd), RELENTLESS_CWND_MIN);
+}
+
+/*
+ * An RTO rebuilds from the one packet window the stack left: rtt_min must
+ * be trusted again before delay backs off, and the rate state is stale.
+ */
+static inline void relentless_restart(struct relentless *ca, u32 cwnd)
+{
+	relentless_adopt_cwnd(ca, cwnd);
+	ca->rtts_observed = 0;
+	ca->bw = 0;
+	ca->prior_bw = 0;
+	ca->alpha = 0;
+}
+
+/* Undo a spurious reduction, raising rtt_cwnd with the restored window */
+static inline u32 relentless_undo(struct relentless *ca, u32 cwnd)
+{
+	cwnd = max(cwnd, ca->save_cwnd);
+	ca->rtt_cwnd = max(ca->rtt_cwnd, relentless_cwnd_to_fp(cwnd));
+	return cwnd;
+}
+
+#endif /* _TCP_RELENTLESS_CORE_H */
@@ -0,0 +1,177 @@
+/*
+ * Relentless TCP tracepoints.
+ *
+ * These replace the old ratelimited printks: they cost a static branch when
+ * nothing is attached, and perf or bpftrace can filter on the ports and
+ * addresses instead of the module matching a single debug connection.
+ */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM relentless
+
+#if !defined(_TCP_RELENTLESS_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TCP_RELENTLESS_TRACE_H
+
+#include <linux/tracepoint.h>
+#include <net/inet_sock.h>
+#include <net/ipv6.h>
+#include <net/tcp.h>
+#include "tcp_relentless_compat.h"
+
+/*
+ * Addresses are kept as sockaddr_in6 sized arrays holding a sockaddr_in or
+ * sockaddr_in6, as the tcp tracepoints do, so %pISpc prints IPv4 and IPv6
+ * (including v4 mapped) endpoints alike.
+ */
+#if IS_ENABLED(CONFIG_IPV6)
+#define RELENTLESS_TP_STORE_V6(__entry, inet, sk)			\
+	do {								\
+		struct sockaddr_in6 *v6 = (void *)__entry->saddr;	\
+									\
+		v6->sin6_family = AF_INET6;				\
+		v6->sin6_port = inet->inet_sport;			\
+		v6->sin6_addr = sk->sk_v6_rcv_saddr;			\
+		v6 = (void *)__entry->daddr;				\
+		v6->sin6_family = AF_INET6;				\
+		v6->sin6_port = inet->inet_dport;			\
+		v6->sin6_addr = sk->sk_v6_daddr;			\
+	} while (0)
+#else
+#define RELENTLESS_TP_STORE_V6(__entry, inet, sk) do { } while (0)
+#endif
+
+#define RELENTLESS_TP_STORE_ADDRS(__entry, inet, sk)			\
+	do {								\
+		memset(__entry->saddr, 0, sizeof(__entry->saddr));	\
+		memset(__entry->daddr, 0, sizeof(__entry->daddr));	\
+		__entry->family = sk->sk_family;			\
+		if (sk->sk_family == AF_INET6) {			\
+			RELENTLESS_TP_STORE_V6(__entry, inet, sk);	\
+		} else {						\
+			struct sockaddr_in *v4 = (void *)__entry->saddr; \
+									\
+			v4->sin_family = AF_INET;			\
+			v4->sin_port = inet->inet_sport;		\
+			v4->sin_addr.s_addr = inet->inet_saddr;		\
+			v4 = (void *)__entry->daddr;			\
+			v4->sin_family = AF_INET;			\
+			v4->sin_port = inet->inet_dport;		\
+			v4->sin_addr.s_addr = inet->inet_daddr;		\
+		}							\
+	} while (0)
+
+DECLARE_EVENT_CLASS(relentless_class,
+
+	TP_PROTO(const struct sock *sk, u32 rtt_min, u32 rtt_thresh, u32 rtt,
+		 u32 rtt_cwnd),
+
+	TP_ARGS(sk, rtt_min, rtt_thresh, rtt, rtt_cwnd),
+
+	TP_STRUCT__entry(
+		__field(const void *, skaddr)
+		__array(__u8, saddr, sizeof(struct sockaddr_in6))
+		__array(__u8, daddr, sizeof(struct sockaddr_in6))
+		__field(__u16, family)
+		__field(__u16, sport)
+		__field(__u16, dport)
+		__field(__u32, rtt_min)
+		__field(__u32, rtt_thresh)
+		__field(__u32, rtt)
+		__field(__u32, rtt_cwnd)
+		__field(__u32, snd_cwnd)
+		__field(__u32, ssthresh)
+	),
+
+	TP_fast_assign(
+		const struct inet_sock *inet = inet_sk(sk);
+		const struct tcp_sock *tp = tcp_sk(sk);
+
+		__entry->skaddr = sk;
+		RELENTLESS_TP_STORE_ADDRS(__entry, inet, sk);
+		__entry->sport = ntohs(inet->inet_sport);
+		__entry->dport = ntohs(inet->inet_dport);
+		__entry->rtt_min = rtt_min;
+		__entry->rtt_thresh = rtt_thresh;
+		__entry->rtt = rtt;
+		__entry->rtt_cwnd = rtt_cwnd;
+		__entry->snd_cwnd = relentless_snd_cwnd(tp);
+		__entry->ssthresh = tp->snd_ssthresh;
+	),
+
+	TP_printk("src=%pISpc dst=%pISpc rtt_min=%u rtt_thresh=%u rtt=%u rtt_cwnd=%u cwnd=%u ssthresh=%u",
+		  __entry->saddr, __entry->daddr,
+		  __entry->rtt_min, __entry->rtt_thresh, __entry->rtt,
+		  __entry->rtt_cwnd, __entry->snd_cwnd, __entry->ssthresh)
+);
+
+DEFINE_EVENT(relentless_class, relentless_init,
+	TP_PROTO(const struct sock *sk, u32 rtt_min, u32 rtt_thresh, u32 rtt,
+		 u32 rtt_cwnd),
+	TP_ARGS(sk, rtt_min, rtt_thresh, rtt, rtt_cwnd)
+);
+
+DEFINE_EVENT(relentless_class, relentless_backoff,
+	TP_PROTO(const struct sock *sk, u32 rtt_min, u32 rtt_thresh, u32 rtt,
+		 u32 rtt_cwnd),
+	TP_ARGS(sk, rtt_min, rtt_thresh, rtt, rtt_cwnd)
+);
+
+DEFINE_EVENT(relentless_class, relentless_exit_slow_start,
+	TP_PROTO(const struct sock *sk, u32 rtt_min, u32 rtt_thresh, u32 rtt,
+		 u32 rtt_cwnd),
+	TP_ARGS(sk, rtt_min, rtt_thresh, rtt, rtt_cwnd)
+);
+
+DEFINE_EVENT(relentless_class, relentless_complete_cwr,
+	TP_PROTO(const struct sock *sk, u32 rtt_min, u32 rtt_thresh, u32 rtt,
+		 u32 rtt_cwnd),
+	TP_ARGS(sk, rtt_min, rtt_thresh, rtt, rtt_cwnd)
+);
+
+TRACE_EVENT(relentless_loss,
+
+	TP_PROTO(const struct sock *sk, u32 losses, u32 rtt_cwnd),
+
+	TP_ARGS(sk, losses, rtt_cwnd),
+
+	TP_STRUCT__entry(
+		__field(const void *, skaddr)
+		__array(__u8, saddr, sizeof(struct sockaddr_in6))
+		__array(__u8, daddr, sizeof(struct sockaddr_in6))
+		__field(__u16, family)
+		__field(__u16, sport)
+		__field(__u16, dport)
+		__field(__u32, losses)
+		__field(__u32, rtt_cwnd)
+		__field(__u32, snd_cwnd)
+		__field(__u32, ssthresh)
+		__field(__u8, ca_state)
+	),
+
+	TP_fast_assign(
+		const struct inet_sock *inet = inet_sk(sk);
+		const struct tcp_sock *tp = tcp_sk(sk);
+
+		__entry->skaddr = sk;
+		RELENTLESS_TP_STORE_ADDRS(__entry, inet, sk);
+		__entry->sport = ntohs(inet->inet_sport);
+		__entry->dport = ntohs(inet->inet_dport);
+		__entry->losses = losses;
+		__entry->rtt_cwnd = rtt_cwnd;
+		__entry->snd_cwnd = relentless_snd_cwnd(tp);
+		__entry->ssthresh = tp->snd_ssthresh;
+		__entry->ca_state = inet_csk(sk)->icsk_ca_state;
+	),
+
+	TP_printk("src=%pISpc dst=%pISpc losses=%u rtt_cwnd=%u cwnd=%u ssthresh=%u ca_state=%u",
+		  __entry->saddr, __entry->daddr,
+		  __entry->losses, __entry->rtt_cwnd, __entry->snd_cwnd,
+		  __entry->ssthresh, __entry->ca_state)
+);
+
+#endif /* _TCP_RELENTLESS_TRACE_H */
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE tcp_relentless_trace
+#include <trace/define_trace.h>